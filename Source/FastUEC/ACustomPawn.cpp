@@ -171,71 +171,77 @@ void ACustomPawn::OnTouchReleased(ETouchIndex::Type FingerIndex, FVector Locatio
     }
 }
 
-bool ACustomPawn::DetectMagicCubeHit(const FVector2D& ScreenPosition, AMagicCubeActor*& OutMagicCube, TArray<EMagicCubeFace>& OutCachedFaces, TArray<EMagicCubeFace>& OutCachedTargetFaces)
+bool ACustomPawn::DetectMagicCubeHit(const FVector2D& ScreenPosition, AMagicCubeActor*& OutMagicCube, FMagicCubeFaceMask& OutCachedFaceMask, FMagicCubeFaceMask& OutCachedTargetFaceMask)
 {
-    if (PC)
-    {
-        // 执行射线检测
-        FHitResult HitResult;
-        bool bHit = PC->GetHitResultUnderCursorByChannel(
-            UEngineTypes::ConvertToTraceType(ECC_Visibility),
-            true, // 复杂碰撞检测
-            HitResult
-        );
+    bIsMagicCubeHit = false; // 重置击中魔方标志
 
-        bIsMagicCubeHit = false; // 重置击中魔方标志
+    // 屏幕坐标反投影成射线
+    FVector RayOrigin, RayDirection;
+    if (!PC || !PC->DeprojectScreenPositionToWorld(ScreenPosition.X, ScreenPosition.Y, RayOrigin, RayDirection))
+    {
+        return false;
+    }
 
-        if (bHit && HitResult.GetActor())
+    // 解析拾取：不走物理查询，直接在每个魔方的网格上求交，取最近的
+    AMagicCubeActor* HitCube = nullptr;
+    FIntVector HitBlock = FIntVector::ZeroValue;
+    FVector HitNormal = FVector::ZeroVector;
+    float HitDistance = TNumericLimits<float>::Max();
+    for (TActorIterator<AMagicCubeActor> It(GetWorld()); It; ++It)
+    {
+        FIntVector Block;
+        FVector Normal;
+        float Distance;
+        if (It->TraceBlock(RayOrigin, RayDirection, Block, Normal, Distance) && Distance < HitDistance)
         {
-            // 尝试获取魔方Actor
-            CachedMagicCube = Cast<AMagicCubeActor>(HitResult.GetActor());
-            if (CachedMagicCube)
-            {
-                bIsMagicCubeHit = true; // 设置击中魔方标志
-
-                // 计算点击到的块索引
-                const FVector LocalPosition = CachedMagicCube->GetActorTransform().InverseTransformPosition(HitResult.ImpactPoint);
-                const int32 x = FMath::RoundToInt((LocalPosition.X + (CachedMagicCube->Dimensions[0] - 1) * 0.5f * CachedMagicCube->BlockSize) / CachedMagicCube->BlockSize);
-                const int32 y = FMath::RoundToInt((LocalPosition.Y + (CachedMagicCube->Dimensions[1] - 1) * 0.5f * CachedMagicCube->BlockSize) / CachedMagicCube->BlockSize);
-                const int32 z = FMath::RoundToInt((LocalPosition.Z + (CachedMagicCube->Dimensions[2] - 1) * 0.5f * CachedMagicCube->BlockSize) / CachedMagicCube->BlockSize);
+            HitCube = *It;
+            HitBlock = Block;
+            HitNormal = Normal;
+            HitDistance = Distance;
+        }
+    }
+    if (!HitCube)
+    {
+        return false;
+    }
 
-                const int32 BlockIndex = CachedMagicCube->GetLinearIndex(x, y, z);
+    CachedMagicCube = HitCube;
+    bIsMagicCubeHit = true; // 设置击中魔方标志
 
-                // 获取归属面集合
-                CachedFaces = CachedMagicCube->GetCubeFacesForBlock(x, y, z);
+    // 获取归属面集合
+    CachedFaceMask = CachedMagicCube->GetCubeFaceMaskForBlock(HitBlock.X, HitBlock.Y, HitBlock.Z);
 
-                // 找到射线击中面
-                EMagicCubeFace HitFace = EMagicCubeFace::Top; // 默认值
-                float MaxDot = -1.0f;
-                for (EMagicCubeFace Face : CachedFaces) // 遍历归属面集合
-                {
-                    FVector FaceNormal = CachedMagicCube->GetFaceNormal(Face);
-                    float DotProduct = FVector::DotProduct(FaceNormal, HitResult.ImpactNormal);
-                    if (DotProduct > MaxDot)
-                    {
-                        MaxDot = DotProduct;
-                        HitFace = Face;
-                    }
-                }
+    // 找到射线击中面：命中法向量已经在魔方局部空间，和 GetFaceNormal 直接比较
+    EMagicCubeFace HitFace = EMagicCubeFace::Top; // 默认值
+    float MaxDot = -1.0f;
+    for (int32 FaceIndex = 0; FaceIndex < NumMagicCubeFaces; FaceIndex++) // 遍历归属面集合
+    {
+        const EMagicCubeFace Face = static_cast<EMagicCubeFace>(FaceIndex);
+        if (!(CachedFaceMask & MagicCubeFaceBit(Face)))
+        {
+            continue;
+        }
+        FVector FaceNormal = CachedMagicCube->GetFaceNormal(Face);
+        float DotProduct = FVector::DotProduct(FaceNormal, HitNormal);
+        if (DotProduct > MaxDot)
+        {
+            MaxDot = DotProduct;
+            HitFace = Face;
+        }
+    }
 
-                // 找到射线击中面的反面
-                EMagicCubeFace OppositeFace = CachedMagicCube->GetOppositeFace(HitFace);
+    // 找到射线击中面的反面
+    EMagicCubeFace OppositeFace = CachedMagicCube->GetOppositeFace(HitFace);
 
-                // 计算目标面集合
-                CachedTargetFaces = CachedFaces;
-                CachedTargetFaces.Remove(HitFace);
-                CachedTargetFaces.Remove(OppositeFace);
+    // 计算目标面集合
+    CachedTargetFaceMask = CachedFaceMask & ~(MagicCubeFaceBit(HitFace) | MagicCubeFaceBit(OppositeFace));
 
-                // 设置输出参数
-                OutMagicCube = CachedMagicCube;
-                OutCachedFaces = CachedFaces;
-                OutCachedTargetFaces = CachedTargetFaces;
+    // 设置输出参数
+    OutMagicCube = CachedMagicCube;
+    OutCachedFaceMask = CachedFaceMask;
+    OutCachedTargetFaceMask = CachedTargetFaceMask;
 
-                return true;
-            }
-        }
-    }
-    return false;
+    return true;
 }
 
 void ACustomPawn::BeginDrag(const FVector2D& InitialPosition)
@@ -248,16 +254,22 @@ void ACustomPawn::BeginDrag(const FVector2D& InitialPosition)
     CurrentRotationAngle = 0.f;
 
     AMagicCubeActor* HitMagicCube = nullptr;
-    TArray<EMagicCubeFace> HitFaces;
-    TArray<EMagicCubeFace> HitTargetFaces;
+    FMagicCubeFaceMask HitFaceMask = 0;
+    FMagicCubeFaceMask HitTargetFaceMask = 0;
+
+    bIsMagicCubeHit = DetectMagicCubeHit(InitialPosition, HitMagicCube, HitFaceMask, HitTargetFaceMask);
 
-    bIsMagicCubeHit = DetectMagicCubeHit(InitialPosition, HitMagicCube, HitFaces, HitTargetFaces);
+    // 魔方还在播放转动动画时不开始拖拽，等这一步落位
+    if (bIsMagicCubeHit && HitMagicCube->IsRotationAnimating())
+    {
+        bIsMagicCubeHit = false;
+    }
 
     if (bIsMagicCubeHit)
     {
         CachedMagicCube = HitMagicCube;
-        CachedFaces = HitFaces;
-        CachedTargetFaces = HitTargetFaces;
+        CachedFaceMask = HitFaceMask;
+        CachedTargetFaceMask = HitTargetFaceMask;
         bIsDraggingCube = true; // 只有当击中魔方时才设置为true
     }
 }
@@ -298,8 +310,14 @@ void ACustomPawn::UpdateDrag(const FVector2D& CurrentPosition)
         }
 
         // 遍历目标面集合，计算鼠标位移和各目标面元素的点积
-        for (EMagicCubeFace Face : CachedTargetFaces)
+        for (int32 FaceIndex = 0; FaceIndex < NumMagicCubeFaces; FaceIndex++)
         {
+            const EMagicCubeFace Face = static_cast<EMagicCubeFace>(FaceIndex);
+            if (!(CachedTargetFaceMask & MagicCubeFaceBit(Face)))
+            {
+                continue;
+            }
+
             // 获取面的旋转方向
             FVector FaceRotateDirection = CachedMagicCube->GetFaceRotateDirection(Face);
             FaceRotateDirection.Normalize(); // 标准化旋转方向
@@ -401,13 +419,7 @@ void ACustomPawn::EndDrag()
             // 执行旋转
             CachedMagicCube->RotateLayer(RotateAxis, LayerIndex, SnapAngle);
         }
-        else
-        {
-            // 重置图层旋转
-            ECubeAxis RotateAxis = CachedMagicCube->GetRotateAxis(RotationFace);
-            int32 LayerIndex = CachedMagicCube->GetLayerIndex(RotationFace);
-            CachedMagicCube->SetLayerRotation(RotateAxis, LayerIndex, 0.f);
-        }
+        // 没过阈值就是一次点击：层拖拽还没开始（RotationFace 也没定），不用复位，也不去取消求解
 
         // 重置拖拽状态
         bIsDraggingCube = false;
@@ -416,8 +428,8 @@ void ACustomPawn::EndDrag()
         bThresholdReached = false;
         bIsMagicCubeHit = false;
         CachedMagicCube = nullptr;
-        CachedFaces.Empty();
-        CachedTargetFaces.Empty();
+        CachedFaceMask = 0;
+        CachedTargetFaceMask = 0;
         CurrentRotationAngle = 0.f;
     }
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 enum class ECubeAxis : uint8;
 enum class EMagicCubeFace : uint8; // 添加 EMagicCubeFace 前向声明
 class AMagicCubeActor;
+using FMagicCubeFaceMask = uint16; // 面集合位掩码，与 MagicCubeActor.h 里的别名相同（同一类型的别名可以重复声明）
 
 #include "ACustomPawn.generated.h"
 
@@ -48,7 +49,7 @@ private:
     void OnTouchReleased(ETouchIndex::Type FingerIndex, FVector Location);
 
     // 解耦后的核心函数
-    bool DetectMagicCubeHit(const FVector2D& ScreenPosition, AMagicCubeActor*& OutMagicCube, TArray<EMagicCubeFace>& OutCachedFaces, TArray<EMagicCubeFace>& OutCachedTargetFaces);
+    bool DetectMagicCubeHit(const FVector2D& ScreenPosition, AMagicCubeActor*& OutMagicCube, FMagicCubeFaceMask& OutCachedFaceMask, FMagicCubeFaceMask& OutCachedTargetFaceMask);
     void BeginDrag(const FVector2D& InitialPosition);
     void UpdateDrag(const FVector2D& CurrentPosition);
     void EndDrag();
@@ -75,12 +76,12 @@ private:
     // 缓存击中的魔方 Actor
     AMagicCubeActor* CachedMagicCube;
 
-    // 缓存击中的魔方块所属的面集合
-    TArray<EMagicCubeFace> CachedFaces;
+    // 缓存击中的魔方块所属的面集合（位掩码，第 EMagicCubeFace 位）
+    FMagicCubeFaceMask CachedFaceMask = 0;
 
     // 缓存击中的魔方块目标面集合 (用于计算旋转方向)
     EMagicCubeFace RotationFace; // 确定旋转的面
-    TArray<EMagicCubeFace> CachedTargetFaces;
+    FMagicCubeFaceMask CachedTargetFaceMask = 0;
 
 public:
     // 摄像机相关
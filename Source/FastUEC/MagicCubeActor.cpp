@@ -1,5 +1,59 @@
 #include "MagicCubeActor.h"
+#include "MagicCubeSolverTables.h"
+#include "MagicCubeSolverTasks.h"
+#include "Containers/Queue.h"
+#include "Tasks/Task.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+DECLARE_STATS_GROUP(TEXT("MagicCube"), STATGROUP_MagicCube, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Layer Transform Update"), STAT_MagicCubeLayerUpdate, STATGROUP_MagicCube);
+
+// 每个实例的自定义数据：方块编号 + 6 个局部方向的贴纸颜色 + 槽位坐标
+static constexpr int32 CubieCustomDataFloats = 10;
+static constexpr int32 SlotCustomDataOffset = 7;
+
+// 材质驱动转动用到的材质参数
+static const FName LayerRotationAxisIndexParam(TEXT("LayerRotationAxisIndex"));
+static const FName LayerRotationLayerParam(TEXT("LayerRotationLayer"));
+static const FName LayerRotationAxisParam(TEXT("LayerRotationAxis"));
+static const FName LayerRotationPivotParam(TEXT("LayerRotationPivot"));
+static const FName LayerRotationAngleParam(TEXT("LayerRotationAngle"));
+
+// 受影响实例下标之间的空隙不超过这个值时合并成同一段提交，空隙用静止实例的当前变换补齐
+static constexpr int32 MaxInstanceBatchGap = 16;
+
+// 纯逻辑核心的四元数换成引擎类型
+static FQuat ToQuat(const MagicCube::FQuatValue& Value)
+{
+    return FQuat(Value.X, Value.Y, Value.Z, Value.W);
+}
+
+static FMagicCubeMove ToMagicCubeMove(const MagicCube::FLayerTurn& Turn)
+{
+    FMagicCubeMove Move;
+    Move.Axis = static_cast<ECubeAxis>(Turn.AxisIndex);
+    Move.Layer = Turn.Layer;
+    Move.QuarterTurns = Turn.QuarterTurns;
+    return Move;
+}
+
+// 后台求解在工作线程和游戏线程之间的交接：工作线程写入结果、进度和流式步骤，Tick 轮询取出
+// Solution 和 bSucceeded 在 bFinished 置位之前写好，游戏线程看到 bFinished 之后才读
+struct FMagicCubeSolveJob
+{
+    MagicCube::FSearchControl Control;
+    TQueue<MagicCube::FLayerTurn, EQueueMode::Spsc> StreamedMoves;
+    TArray<FMagicCubeMove> Solution;
+    bool bSucceeded = false;
+    std::atomic<bool> bFinished{ false };
+
+    // 以下只在游戏线程上访问
+    bool bStreaming = false;
+    int32 SnapshotMoveCount = 0;
+    int64 ReportedNodes = -1;
+    int32 ReportedDepth = -1;
+};
 
 AMagicCubeActor::AMagicCubeActor()
 {
@@ -32,11 +86,29 @@ void AMagicCubeActor::OnConstruction(const FTransform& Transform)
     }
     if (CubeMaterial)
     {
-        InstancedMesh->SetMaterial(0, CubeMaterial);
+        const int32 NumSlots = bStickerColorsFromCustomData ? FMath::Max(InstancedMesh->GetNumMaterials(), 1) : 1;
+        for (int32 Slot = 0; Slot < NumSlots; Slot++)
+        {
+            InstancedMesh->SetMaterial(Slot, CubeMaterial);
+        }
     }
+    // 自定义数据只给会读它的材质分配：没人读时每个实例不多带数据，贴纸颜色用不到槽位坐标
+    const int32 NumCustomDataFloats = bShaderLayerRotation ? CubieCustomDataFloats : (bStickerColorsFromCustomData ? SlotCustomDataOffset : 0);
+    const bool bCustomDataResized = InstancedMesh->NumCustomDataFloats != NumCustomDataFloats;
+    if (bCustomDataResized)
+    {
+        InstancedMesh->SetNumCustomDataFloats(NumCustomDataFloats);
+    }
+    InstancedMesh->SetCollisionEnabled(bEnableInstanceCollision ? ECollisionEnabled::QueryAndPhysics : ECollisionEnabled::NoCollision);
+    bCollisionSuspended = false;
     
-    InstancedMesh->ClearInstances();
+    // 编辑器里拖动属性时每次都会走到这里，已有实例和顶面部件尽量复用，只改变了的部分
     InitializeCube();
+    // 改自定义数据个数会清掉所有实例的数据，增量路径只写变了的实例，这里整体补写一次
+    if (bCustomDataResized)
+    {
+        WriteCubieCustomData();
+    }
     
     if (Dimensions.Num() >= 3)
     {
@@ -46,373 +118,1374 @@ void AMagicCubeActor::OnConstruction(const FTransform& Transform)
 
 void AMagicCubeActor::BeginPlay()
 {
-    Super::BeginPlay();
-    InitialTransforms.Empty();
-    int32 InstanceCount = InstancedMesh->GetInstanceCount();
-    for (int32 i = 0; i < InstanceCount; i++)
+    Super::BeginPlay();
+    InitializeCubeState();
+    // 动态材质实例是 Transient，只在运行时建；编辑器里不转层，构造时也就不往材质槽里塞临时对象
+    InitializeLayerRotationMaterials();
+
+    // 部件表按方块编号索引，不序列化，打包后没有 OnConstruction 时按已保存的分组组件重建，实例原样复用
+    if (Dimensions.Num() >= 3)
+    {
+        InitializeTopParts();
+    }
+
+    // 转动时逐步更新部件只按 CubieTopParts 查表，查不到就静默跳过，这里确认表、分组组件和实例都对得上
+    bool bTopPartsValid = CubieTopParts.Num() == CubeState.GetNumCubies();
+    for (const FTopPart& Part : TopParts)
+    {
+        bTopPartsValid &= TopPartInstancedMeshes.IsValidIndex(Part.Group) && TopPartInstancedMeshes[Part.Group]
+            && Part.Instance < TopPartInstancedMeshes[Part.Group]->GetInstanceCount()
+            && CubieTopParts.IsValidIndex(Part.Cubie);
+    }
+    ensureMsgf(bTopPartsValid, TEXT("MagicCube: top part tables do not match the cube state after BeginPlay"));
+}
+
+void AMagicCubeActor::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+    
+    if (FMath::Abs(CurrentRotation.RemainingDegrees) > KINDA_SMALL_NUMBER)
+    {
+        float DeltaRotation = FMath::Sign(CurrentRotation.RemainingDegrees) *
+            FMath::Min(RotationSpeed * DeltaTime, FMath::Abs(CurrentRotation.RemainingDegrees));
+        
+        CurrentRotation.RemainingDegrees -= DeltaRotation;
+        
+        if (FMath::IsNearlyZero(CurrentRotation.RemainingDegrees))
+        {
+            FinishLayerRotation();
+        }
+        else
+        {
+            // 每帧直接用总角度从基准变换算出结果，不做增量累乘
+            ApplyRotationToInstances(CurrentRotation.TargetAngle - CurrentRotation.RemainingDegrees);
+        }
+    }
+
+    UpdateSolveJob();
+    ProcessPendingMoves();
+
+    // 转动全部结束（包括队列）后才恢复碰撞，连续播放的转动之间不反复重建
+    if (bCollisionSuspended && !IsLayerTurning() && GetPendingMoveCount() == 0)
+    {
+        RestoreInstanceCollision();
+    }
+}
+
+void AMagicCubeActor::SuspendInstanceCollision()
+{
+    if (bEnableInstanceCollision && bSuspendCollisionWhileTurning && !bCollisionSuspended)
+    {
+        InstancedMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+        bCollisionSuspended = true;
+    }
+}
+
+void AMagicCubeActor::RestoreInstanceCollision()
+{
+    // 重新打开碰撞时物理体按实例当前变换一次性重建，实例此时都已落位
+    if (bCollisionSuspended)
+    {
+        InstancedMesh->SetCollisionEnabled(bEnableInstanceCollision ? ECollisionEnabled::QueryAndPhysics : ECollisionEnabled::NoCollision);
+        bCollisionSuspended = false;
+    }
+}
+
+void AMagicCubeActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    CancelSolve();
+    Super::EndPlay(EndPlayReason);
+}
+
+void AMagicCubeActor::FinishLayerRotation()
+{
+    CurrentRotation.RemainingDegrees = 0.0f;
+
+    // 提交到离散状态，层成员关系只由这里维护
+    if (CubeState.ApplyMove(GetDimensionIndex(CurrentRotation.Axis), CurrentRotation.Layer, CurrentRotation.QuarterTurns))
+    {
+        Facelets.ApplyMove(GetDimensionIndex(CurrentRotation.Axis), CurrentRotation.Layer, CurrentRotation.QuarterTurns);
+        if (CurrentRotation.QuarterTurns % 4 != 0)
+        {
+            CommittedMoveCount++;
+        }
+    }
+    const bool bBecameSolved = UpdateSolvedState();
+
+    // 落位：方块变换直接由离散状态算出，动画过程中的浮点误差不会留下来
+    for (int32 i = 0; i < CurrentDragCubies.Num(); i++)
+    {
+        const FIntPoint& BatchSlot = CurrentDragBatchSlots[i];
+        CurrentDragBatchRuns[BatchSlot.X].Transforms[BatchSlot.Y] = GetCubieTransform(CurrentDragCubies[i]);
+    }
+    FlushLayerBatchRuns();
+    if (IsShaderLayerRotationActive())
+    {
+        WriteCubieSlotCustomData(CurrentDragCubies);
+    }
+    UpdateTopPartsForLayerRotation(FQuat::Identity, /*bCommitted=*/ true);
+    
+    OnRotationComplete.Broadcast(CurrentRotation.Axis, CurrentRotation.Layer);
+    if (bBecameSolved)
+    {
+        OnCubeSolved.Broadcast();
+    }
+    EndLayerRotationDrag();
+}
+
+void AMagicCubeActor::InitializeCube()
+{
+    // 只改了布局掩码（或剔除开关）时按变化的槽位增量更新，只写这些槽位对应的实例
+    if (UpdateCubeLayout())
+    {
+        return;
+    }
+
+    // 尺寸、方块大小变了，或者离散状态不在还原位置：整体重建离散状态，实例按 InstanceHomeSlots（对不上时按槽位顺序）一一对应
+    // 已有实例只在变换变了时重写；多出的从末尾删掉，不会打乱前面的下标；不够的在末尾追加
+    InitializeCubeState();
+
+    const int32 NumCubies = InstanceCubies.Num();
+    const int32 NumExisting = InstancedMesh->GetInstanceCount();
+    if (NumExisting > NumCubies)
+    {
+        TArray<int32> RemovedInstances;
+        RemovedInstances.Reserve(NumExisting - NumCubies);
+        for (int32 Index = NumExisting - 1; Index >= NumCubies; Index--)
+        {
+            RemovedInstances.Add(Index);
+        }
+        InstancedMesh->RemoveInstances(RemovedInstances, /*bInstanceArrayAlreadySortedInReverseOrder=*/ true);
+    }
+
+    bool bChanged = false;
+    const int32 NumKept = FMath::Min(NumExisting, NumCubies);
+    for (int32 Instance = 0; Instance < NumKept; Instance++)
+    {
+        const FTransform Target = GetCubieTransform(InstanceCubies[Instance]);
+        FTransform Current;
+        InstancedMesh->GetInstanceTransform(Instance, Current, /*bWorldSpace=*/ false);
+        if (!Current.Equals(Target, KINDA_SMALL_NUMBER))
+        {
+            InstancedMesh->UpdateInstanceTransform(Instance, Target, /*bWorldSpace=*/ false, /*bMarkRenderStateDirty=*/ false, /*bTeleport=*/ true);
+            bChanged = true;
+        }
+    }
+
+    if (NumCubies > NumKept)
+    {
+        RefreshTransforms.Reset(NumCubies - NumKept);
+        for (int32 Instance = NumKept; Instance < NumCubies; Instance++)
+        {
+            RefreshTransforms.Add(GetCubieTransform(InstanceCubies[Instance]));
+        }
+        InstancedMesh->AddInstances(RefreshTransforms, /*bShouldReturnIndices=*/ false, /*bWorldSpace=*/ false);
+    }
+    if (bChanged)
+    {
+        InstancedMesh->MarkRenderStateDirty();
+    }
+
+    WriteCubieCustomData();
+
+    BuiltLayoutMask = LayoutMask;
+    BuiltDimensions = FIntVector(Dimensions[0], Dimensions[1], Dimensions[2]);
+    BuiltBlockSize = BlockSize;
+    BuiltBlockScale = BlockScale;
+    bBuiltCullInteriorCubies = bCullInteriorCubies;
+}
+
+bool AMagicCubeActor::UpdateCubeLayout()
+{
+    // 实例变换只由槽位和朝向决定：尺寸和方块大小没变、离散状态在还原位置时，留下来的实例一个都不用动
+    // 没有空槽的 2 阶、3 阶走固定阶数内核，方块编号必须等于槽位，总共不到 27 个方块，直接整体重建
+    const int32 TotalSlots = Dimensions[0] * Dimensions[1] * Dimensions[2];
+    const int32 NumInstances = InstancedMesh->GetInstanceCount();
+    const bool bSmallCube = Dimensions[0] == Dimensions[1] && Dimensions[1] == Dimensions[2] && Dimensions[0] <= 3;
+    if (bSmallCube || !CubeState.IsValid() || CommittedMoveCount != HomeStateMoveCount
+        || BuiltDimensions != FIntVector(Dimensions[0], Dimensions[1], Dimensions[2])
+        || BuiltBlockSize != BlockSize || BuiltBlockScale != ComputeBlockScale()
+        || BuiltLayoutMask.Num() != TotalSlots || LayoutMask.Num() != TotalSlots
+        || InstanceHomeSlots.Num() != NumInstances || InstanceCubies.Num() != NumInstances
+        || CubieInstances.Num() != CubeState.GetNumCubies())
+    {
+        return false;
+    }
+
+    TArray<int32> ChangedSlots;
+    int32 NewNumCubies = CubeState.GetNumCubies();
+    for (int32 Slot = 0; Slot < TotalSlots; Slot++)
+    {
+        if (LayoutMask[Slot] != BuiltLayoutMask[Slot])
+        {
+            ChangedSlots.Add(Slot);
+            NewNumCubies += LayoutMask[Slot] ? 1 : -1;
+        }
+    }
+    const bool bOldCull = bBuiltCullInteriorCubies && CubeState.GetNumCubies() == TotalSlots;
+    const bool bNewCull = bCullInteriorCubies && NewNumCubies == TotalSlots;
+    bBuiltCullInteriorCubies = bCullInteriorCubies;
+    if (ChangedSlots.Num() == 0 && bOldCull == bNewCull)
+    {
+        return true;
+    }
+
+    // 可见性变了的槽位：一般只有掩码变了的那些；剔除与否翻转时（第一次挖空或补满）内部槽位全都跟着变
+    TArray<int32> CandidateSlots;
+    if (bOldCull != bNewCull)
+    {
+        CandidateSlots.Reserve(TotalSlots);
+        for (int32 Slot = 0; Slot < TotalSlots; Slot++)
+        {
+            CandidateSlots.Add(Slot);
+        }
+    }
+    TArray<int32> FreeInstances;
+    TArray<int32> ShownSlots;
+    for (int32 Slot : (bOldCull != bNewCull) ? CandidateSlots : ChangedSlots)
+    {
+        const bool bWasVisible = BuiltLayoutMask[Slot] && IsHomeSlotVisible(Slot, bOldCull);
+        const bool bVisible = LayoutMask[Slot] && IsHomeSlotVisible(Slot, bNewCull);
+        if (bWasVisible && !bVisible)
+        {
+            // 还在还原位置，槽位上的就是以它为初始槽位的方块
+            const int32 Cubie = CubeState.GetCubieAtSlot(Slot);
+            FreeInstances.Add(CubieInstances[Cubie]);
+            CubieInstances[Cubie] = INDEX_NONE;
+        }
+        else if (!bWasVisible && bVisible)
+        {
+            ShownSlots.Add(Slot);
+        }
+    }
+
+    // 离散状态逐个增删方块；拿掉方块时编号最大的方块顶上它的编号，以编号为下标的对应表跟着改
+    for (int32 Slot : ChangedSlots)
+    {
+        if (LayoutMask[Slot])
+        {
+            verify(CubeState.AddCubie(Slot));
+            CubieInstances.Add(INDEX_NONE);
+        }
+        else
+        {
+            const int32 Cubie = CubeState.GetCubieAtSlot(Slot);
+            int32 MovedCubie = MagicCube::InvalidIndex;
+            verify(CubeState.RemoveCubie(Slot, MovedCubie));
+            if (MovedCubie != MagicCube::InvalidIndex)
+            {
+                CubieInstances[Cubie] = CubieInstances[MovedCubie];
+                if (CubieInstances[Cubie] != INDEX_NONE)
+                {
+                    InstanceCubies[CubieInstances[Cubie]] = Cubie;
+                }
+            }
+            CubieInstances.Pop(EAllowShrinking::No);
+        }
+        BuiltLayoutMask[Slot] = LayoutMask[Slot];
+    }
+
+    // 把某个槽位的方块放到某个实例上：对应表、变换和自定义数据各写一次
+    const int32 NumFloats = FMath::Min(InstancedMesh->NumCustomDataFloats, CubieCustomDataFloats);
+    auto AssignInstance = [this, NumFloats](int32 Instance, int32 HomeSlot)
+    {
+        const int32 Cubie = CubeState.GetCubieAtSlot(HomeSlot);
+        InstanceHomeSlots[Instance] = HomeSlot;
+        InstanceCubies[Instance] = Cubie;
+        CubieInstances[Cubie] = Instance;
+        InstancedMesh->UpdateInstanceTransform(Instance, GetCubieTransform(Cubie), /*bWorldSpace=*/ false, /*bMarkRenderStateDirty=*/ false, /*bTeleport=*/ true);
+        WriteInstanceCustomData(Instance, NumFloats);
+    };
+
+    // 新露出来的槽位先填进空出来的实例
+    const int32 NumReused = FMath::Min(FreeInstances.Num(), ShownSlots.Num());
+    for (int32 i = 0; i < NumReused; i++)
+    {
+        AssignInstance(FreeInstances[i], ShownSlots[i]);
+    }
+
+    // 还空着的实例从大到小用末尾的实例填上，再从末尾一起删掉，其余实例的下标不变
+    TArray<int32> Holes(FreeInstances.GetData() + NumReused, FreeInstances.Num() - NumReused);
+    Holes.Sort(TGreater<int32>());
+    int32 NumKept = NumInstances;
+    for (int32 Hole : Holes)
+    {
+        const int32 Last = --NumKept;
+        if (Hole != Last)
+        {
+            AssignInstance(Hole, InstanceHomeSlots[Last]);
+        }
+    }
+    if (NumKept < NumInstances)
+    {
+        TArray<int32> RemovedInstances;
+        RemovedInstances.Reserve(NumInstances - NumKept);
+        for (int32 Index = NumInstances - 1; Index >= NumKept; Index--)
+        {
+            RemovedInstances.Add(Index);
+        }
+        InstancedMesh->RemoveInstances(RemovedInstances, /*bInstanceArrayAlreadySortedInReverseOrder=*/ true);
+        InstanceHomeSlots.SetNum(NumKept);
+        InstanceCubies.SetNum(NumKept);
+    }
+
+    // 还不够的在末尾追加
+    if (ShownSlots.Num() > NumReused)
+    {
+        RefreshTransforms.Reset(ShownSlots.Num() - NumReused);
+        for (int32 i = NumReused; i < ShownSlots.Num(); i++)
+        {
+            const int32 Cubie = CubeState.GetCubieAtSlot(ShownSlots[i]);
+            InstanceHomeSlots.Add(ShownSlots[i]);
+            CubieInstances[Cubie] = InstanceCubies.Add(Cubie);
+            RefreshTransforms.Add(GetCubieTransform(Cubie));
+        }
+        const int32 FirstAdded = InstancedMesh->GetInstanceCount();
+        InstancedMesh->AddInstances(RefreshTransforms, /*bShouldReturnIndices=*/ false, /*bWorldSpace=*/ false);
+        for (int32 Instance = FirstAdded; Instance < InstancedMesh->GetInstanceCount(); Instance++)
+        {
+            WriteInstanceCustomData(Instance, NumFloats);
+        }
+    }
+    InstancedMesh->MarkRenderStateDirty();
+
+    // 方块变了，进行中的求解快照作废；状态仍在还原位置
+    bIsSolved = CubeState.IsSolved();
+    CommittedMoveCount++;
+    HomeStateMoveCount = CommittedMoveCount;
+    return true;
+}
+
+bool AMagicCubeActor::IsHomeSlotVisible(int32 Slot, bool bCull) const
+{
+    // 层转动只在层内旋转另外两个坐标，贴着边界的坐标转完仍贴着边界，所以内部方块永远在内部
+    const MagicCube::FCoords Home = CubeState.GetSlotCoords(Slot);
+    const bool bInterior = Home.X > 0 && Home.X < Dimensions[0] - 1
+        && Home.Y > 0 && Home.Y < Dimensions[1] - 1
+        && Home.Z > 0 && Home.Z < Dimensions[2] - 1;
+    return !bCull || !bInterior;
+}
+
+void AMagicCubeActor::WriteCubieCustomData()
+{
+    // 贴纸跟着方块一起转，在方块局部坐标系下颜色永远不变，朝向已经在实例变换里
+    // 所以整块数据只在实例创建时写，材质驱动转动时整体刷新再写一次、转动提交只改槽位坐标；和已有数据相同的实例跳过
+    // 只写组件分配了的前几个，一个都没分配就不用写
+    const int32 NumFloats = FMath::Min(InstancedMesh->NumCustomDataFloats, CubieCustomDataFloats);
+    if (NumFloats <= 0)
+    {
+        return;
+    }
+    bool bChanged = false;
+    const int32 NumInstances = FMath::Min(InstancedMesh->GetInstanceCount(), InstanceCubies.Num());
+    for (int32 Instance = 0; Instance < NumInstances; Instance++)
+    {
+        bChanged |= WriteInstanceCustomData(Instance, NumFloats);
+    }
+    if (bChanged)
+    {
+        InstancedMesh->MarkRenderStateDirty();
+    }
+}
+
+bool AMagicCubeActor::WriteInstanceCustomData(int32 Instance, int32 NumFloats)
+{
+    if (NumFloats <= 0)
+    {
+        return false;
+    }
+    float Data[CubieCustomDataFloats];
+    const int32 Cubie = InstanceCubies[Instance];
+    const int32 HomeSlot = CubeState.GetCubieHomeSlot(Cubie);
+    const MagicCube::FCoords Home = CubeState.GetSlotCoords(HomeSlot);
+    Data[0] = static_cast<float>(HomeSlot);
+    for (int32 AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+    {
+        const int32 Positive = AxisIndex * 2;
+        const int32 Negative = AxisIndex * 2 + 1;
+        Data[1 + Positive] = (Home[AxisIndex] == Dimensions[AxisIndex] - 1) ? static_cast<float>(Positive) : -1.0f;
+        Data[1 + Negative] = (Home[AxisIndex] == 0) ? static_cast<float>(Negative) : -1.0f;
+    }
+    // 槽位坐标只在开启材质驱动转动时分配；材质还没接管转动（编辑器里）时写初始槽位，和当前槽位相同
+    const MagicCube::FCoords Coords = IsShaderLayerRotationActive() ? CubeState.GetSlotCoords(CubeState.GetCubieSlot(Cubie)) : Home;
+    for (int32 AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+    {
+        Data[SlotCustomDataOffset + AxisIndex] = static_cast<float>(Coords[AxisIndex]);
+    }
+
+    const int32 Offset = Instance * NumFloats;
+    if (InstancedMesh->PerInstanceSMCustomData.Num() >= Offset + NumFloats
+        && FMemory::Memcmp(InstancedMesh->PerInstanceSMCustomData.GetData() + Offset, Data, NumFloats * sizeof(float)) == 0)
+    {
+        return false;
+    }
+    InstancedMesh->SetCustomData(Instance, MakeArrayView(Data, NumFloats), /*bMarkRenderStateDirty=*/ false);
+    return true;
+}
+
+void AMagicCubeActor::WriteCubieSlotCustomData(TArrayView<const int32> Cubies)
+{
+    // 材质按槽位坐标判断实例在不在转动层里，提交后马上换成新槽位
+    const int32 NumInstances = InstancedMesh->GetInstanceCount();
+    for (int32 Cubie : Cubies)
+    {
+        const int32 Instance = CubieInstances.IsValidIndex(Cubie) ? CubieInstances[Cubie] : INDEX_NONE;
+        if (Instance == INDEX_NONE || Instance >= NumInstances)
+        {
+            continue;
+        }
+        const MagicCube::FCoords Coords = CubeState.GetSlotCoords(CubeState.GetCubieSlot(Cubie));
+        for (int32 AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+        {
+            InstancedMesh->SetCustomDataValue(Instance, SlotCustomDataOffset + AxisIndex, static_cast<float>(Coords[AxisIndex]), /*bMarkRenderStateDirty=*/ false);
+        }
+    }
+    InstancedMesh->MarkRenderStateDirty();
+}
+
+void AMagicCubeActor::InitializeLayerRotationMaterials()
+{
+    // 槽里已经是动态实例就直接用，否则按父材质复用或新建一个，每帧要设参数的材质尽量少
+    LayerRotationMaterials.Reset();
+    if (!bShaderLayerRotation)
+    {
+        return;
+    }
+    for (int32 Slot = 0; Slot < InstancedMesh->GetNumMaterials(); Slot++)
+    {
+        UMaterialInterface* SlotMaterial = InstancedMesh->GetMaterial(Slot);
+        if (!SlotMaterial)
+        {
+            continue;
+        }
+        UMaterialInstanceDynamic* Material = Cast<UMaterialInstanceDynamic>(SlotMaterial);
+        if (!Material)
+        {
+            UMaterialInstanceDynamic** Existing = LayerRotationMaterials.FindByPredicate(
+                [SlotMaterial](const UMaterialInstanceDynamic* Candidate) { return Candidate->Parent == SlotMaterial; });
+            Material = Existing ? *Existing : UMaterialInstanceDynamic::Create(SlotMaterial, this);
+            InstancedMesh->SetMaterial(Slot, Material);
+        }
+        LayerRotationMaterials.AddUnique(Material);
+    }
+    SetLayerRotationMaterialLayer(false);
+}
+
+void AMagicCubeActor::SetLayerRotationMaterialLayer(bool bActive)
+{
+    // 世界位置偏移在世界空间里算，轴和枢轴按组件当前变换换过去；转动期间魔方本身不应移动
+    const FTransform& ComponentTransform = InstancedMesh->GetComponentTransform();
+    const int32 DimIndex = GetDimensionIndex(CurrentDragAxis);
+    FVector LocalAxis = FVector::ZeroVector;
+    LocalAxis[DimIndex] = 1.0f;
+    const FLinearColor WorldAxis(ComponentTransform.TransformVectorNoScale(LocalAxis));
+    const FLinearColor WorldPivot(ComponentTransform.TransformPosition(CurrentDragPivot));
+    for (UMaterialInstanceDynamic* Material : LayerRotationMaterials)
+    {
+        Material->SetScalarParameterValue(LayerRotationAxisIndexParam, static_cast<float>(DimIndex));
+        Material->SetScalarParameterValue(LayerRotationLayerParam, bActive ? static_cast<float>(CurrentDragLayer) : -1.0f);
+        Material->SetVectorParameterValue(LayerRotationAxisParam, WorldAxis);
+        Material->SetVectorParameterValue(LayerRotationPivotParam, WorldPivot);
+        Material->SetScalarParameterValue(LayerRotationAngleParam, 0.0f);
+    }
+}
+
+void AMagicCubeActor::InitializeCubeState()
+{
+    // 方块编号按布局掩码里有方块的槽位顺序分配，实例再从方块里挑出需要显示的
+    CubeState.Initialize(MagicCube::FCoords{ Dimensions[0], Dimensions[1], Dimensions[2] }, LayoutMask.GetData(), LayoutMask.Num());
+    Facelets.Initialize((Dimensions[0] == Dimensions[1] && Dimensions[1] == Dimensions[2]) ? Dimensions[0] : 0);
+    bIsSolved = CubeState.IsSolved();
+    BlockScale = ComputeBlockScale();
+    CommittedMoveCount++;
+    HomeStateMoveCount = CommittedMoveCount;
+    BuildCubieInstances();
+    // 合法角度表不序列化，和离散状态一起建，打包后只走 BeginPlay 也有
+    BuildLayerTurnTable();
+}
+
+void AMagicCubeActor::BuildCubieInstances()
+{
+    // 有空槽时内部方块可能挨着空槽露出来，整体不剔除
+    const int32 NumCubies = CubeState.GetNumCubies();
+    const bool bCull = bCullInteriorCubies && NumCubies == Dimensions[0] * Dimensions[1] * Dimensions[2];
+    int32 NumVisible = 0;
+    for (int32 Cubie = 0; Cubie < NumCubies; Cubie++)
+    {
+        NumVisible += IsHomeSlotVisible(CubeState.GetCubieHomeSlot(Cubie), bCull) ? 1 : 0;
+    }
+
+    // 先沿用保存下来的实例顺序：增量改过布局后实例不按槽位顺序排列，运行时要和已有实例一一对上
+    // 刚 Initialize 过，状态在还原位置，初始槽位上的就是对应的方块
+    CubieInstances.Init(INDEX_NONE, NumCubies);
+    InstanceCubies.Reset(NumCubies);
+    bool bMatches = InstanceHomeSlots.Num() == NumVisible;
+    for (int32 Instance = 0; Instance < InstanceHomeSlots.Num() && bMatches; Instance++)
+    {
+        const int32 HomeSlot = InstanceHomeSlots[Instance];
+        const int32 Cubie = (HomeSlot >= 0 && HomeSlot < CubeState.GetNumSlots()) ? CubeState.GetCubieAtSlot(HomeSlot) : MagicCube::InvalidIndex;
+        bMatches = Cubie != MagicCube::InvalidIndex && CubieInstances[Cubie] == INDEX_NONE && IsHomeSlotVisible(HomeSlot, bCull);
+        if (bMatches)
+        {
+            CubieInstances[Cubie] = InstanceCubies.Add(Cubie);
+        }
+    }
+    if (bMatches)
+    {
+        return;
+    }
+
+    // 对不上（第一次构造、尺寸变了）时按方块编号也就是槽位顺序排
+    CubieInstances.Init(INDEX_NONE, NumCubies);
+    InstanceCubies.Reset(NumCubies);
+    InstanceHomeSlots.Reset(NumVisible);
+    for (int32 Cubie = 0; Cubie < NumCubies; Cubie++)
+    {
+        const int32 HomeSlot = CubeState.GetCubieHomeSlot(Cubie);
+        if (IsHomeSlotVisible(HomeSlot, bCull))
+        {
+            CubieInstances[Cubie] = InstanceCubies.Add(Cubie);
+            InstanceHomeSlots.Add(HomeSlot);
+        }
+    }
+}
+
+float AMagicCubeActor::ComputeBlockScale() const
+{
+    float ComputedScale = 1.0f;
+    if (CubeMesh)
+    {
+        FBoxSphereBounds MeshBounds = CubeMesh->GetBounds();
+        float MeshSize = MeshBounds.BoxExtent.GetMax() * 2.0f;
+        if (MeshSize > KINDA_SMALL_NUMBER)
+        {
+            ComputedScale = BlockSize / MeshSize;
+        }
+    }
+    else
+    {
+        ComputedScale = BlockSize / 100.0f;
+    }
+    return ComputedScale;
+}
+
+FTransform AMagicCubeActor::GetCubieTransform(int32 Cubie) const
+{
+    // 组件局部空间下，方块的变换完全由所在槽位和朝向决定
+    const MagicCube::FCoords Coords = CubeState.GetSlotCoords(CubeState.GetCubieSlot(Cubie));
+    return FTransform(
+        ToQuat(MagicCube::GetOrientationQuat(CubeState.GetCubieOrientation(Cubie))),
+        CalculatePosition(Coords.X, Coords.Y, Coords.Z),
+        FVector(BlockScale));
+}
+
+FVector AMagicCubeActor::GetLayerPivot(ECubeAxis Axis, int32 Layer) const
+{
+    // 层的几何中心（组件局部空间），不依赖实例当前位置
+    const int32 DimIndex = GetDimensionIndex(Axis);
+    FVector Pivot = FVector::ZeroVector;
+    Pivot[DimIndex] = (Layer - (Dimensions[DimIndex] - 1) / 2.0f) * BlockSize;
+    return Pivot;
+}
+
+FQuat AMagicCubeActor::GetLayerRotationQuat(ECubeAxis Axis, float Angle) const
+{
+    // 90° 的整数倍直接查朝向表，保证落位是精确值
+    const float Quarters = Angle / 90.0f;
+    if (FMath::IsNearlyEqual(Quarters, FMath::RoundToFloat(Quarters), KINDA_SMALL_NUMBER))
+    {
+        return ToQuat(MagicCube::GetOrientationQuat(
+            MagicCube::GetQuarterTurnOrientation(GetDimensionIndex(Axis), FMath::RoundToInt(Quarters))));
+    }
+
+    FVector RotationAxis;
+    switch (Axis)
+    {
+        case ECubeAxis::X: RotationAxis = FVector::ForwardVector; break;
+        case ECubeAxis::Y: RotationAxis = FVector::RightVector;   break;
+        case ECubeAxis::Z: RotationAxis = FVector::UpVector;      break;
+        default:           RotationAxis = FVector::ZeroVector;    break;
+    }
+    return FQuat(RotationAxis, FMath::DegreesToRadians(Angle));
+}
+
+FVector AMagicCubeActor::CalculatePosition(int32 x, int32 y, int32 z) const
+{
+    float OffsetX = (x - (Dimensions[0] - 1) / 2.0f) * BlockSize;
+    float OffsetY = (y - (Dimensions[1] - 1) / 2.0f) * BlockSize;
+    float OffsetZ = (z - (Dimensions[2] - 1) / 2.0f) * BlockSize;
+    return FVector(OffsetX, OffsetY, OffsetZ);
+}
+
+int32 AMagicCubeActor::GetLinearIndex(int32 x, int32 y, int32 z) const
+{
+    return x + y * Dimensions[0] + z * Dimensions[0] * Dimensions[1];
+}
+
+bool AMagicCubeActor::IsSlotOccupied(int32 x, int32 y, int32 z) const
+{
+    const int32 Slot = GetLinearIndex(x, y, z);
+    if (CubeState.IsValid())
+    {
+        return CubeState.GetCubieAtSlot(Slot) != MagicCube::InvalidIndex;
+    }
+    return LayoutMask.IsValidIndex(Slot) ? LayoutMask[Slot] : true;
+}
+
+bool AMagicCubeActor::TraceBlock(const FVector& RayOrigin, const FVector& RayDirection, FIntVector& OutBlock, FVector& OutLocalNormal, float& OutDistance) const
+{
+    // 换到格子空间：格子 i 占 [i, i + 1)，整个网格是 [0, Dimensions]
+    // 仿射变换不改变射线参数，所以这里的 t 乘上世界方向的长度就是世界距离
+    const FTransform& ComponentTransform = InstancedMesh->GetComponentTransform();
+    FVector Origin = ComponentTransform.InverseTransformPosition(RayOrigin) / BlockSize;
+    const FVector Direction = ComponentTransform.InverseTransformVector(RayDirection) / BlockSize;
+    for (int32 Axis = 0; Axis < 3; Axis++)
+    {
+        Origin[Axis] += Dimensions[Axis] * 0.5f;
+    }
+
+    // 先和整个网格的包围盒求交，记下从哪个轴进入
+    double EnterT = 0.0;
+    double ExitT = TNumericLimits<double>::Max();
+    int32 EnterAxis = INDEX_NONE;
+    for (int32 Axis = 0; Axis < 3; Axis++)
+    {
+        if (FMath::IsNearlyZero(Direction[Axis]))
+        {
+            if (Origin[Axis] < 0.0 || Origin[Axis] >= Dimensions[Axis])
+            {
+                return false;
+            }
+            continue;
+        }
+        double Near = (0.0 - Origin[Axis]) / Direction[Axis];
+        double Far = (Dimensions[Axis] - Origin[Axis]) / Direction[Axis];
+        if (Near > Far)
+        {
+            Swap(Near, Far);
+        }
+        if (Near > EnterT)
+        {
+            EnterT = Near;
+            EnterAxis = Axis;
+        }
+        ExitT = FMath::Min(ExitT, Far);
+    }
+    if (EnterT > ExitT)
+    {
+        return false;
+    }
+
+    // 3D-DDA：每一步跨过最近的一个格子边界
+    int32 Cell[3];
+    int32 Step[3];
+    double NextT[3];
+    double DeltaT[3];
+    const FVector Entry = Origin + Direction * EnterT;
+    const bool bBoundsOnly = IsLayerTurning();
+    for (int32 Axis = 0; Axis < 3; Axis++)
+    {
+        Cell[Axis] = FMath::Clamp(FMath::FloorToInt32(Entry[Axis]), 0, Dimensions[Axis] - 1);
+        if (Direction[Axis] > 0.0)
+        {
+            Step[Axis] = 1;
+            NextT[Axis] = (Cell[Axis] + 1 - Origin[Axis]) / Direction[Axis];
+            DeltaT[Axis] = 1.0 / Direction[Axis];
+        }
+        else if (Direction[Axis] < 0.0)
+        {
+            Step[Axis] = -1;
+            NextT[Axis] = (Cell[Axis] - Origin[Axis]) / Direction[Axis];
+            DeltaT[Axis] = -1.0 / Direction[Axis];
+        }
+        else
+        {
+            Step[Axis] = 0;
+            NextT[Axis] = TNumericLimits<double>::Max();
+            DeltaT[Axis] = TNumericLimits<double>::Max();
+        }
+    }
+
+    double T = EnterT;
+    while (true)
+    {
+        if (bBoundsOnly || IsSlotOccupied(Cell[0], Cell[1], Cell[2]))
+        {
+            OutBlock = FIntVector(Cell[0], Cell[1], Cell[2]);
+            OutLocalNormal = FVector::ZeroVector;
+            if (EnterAxis != INDEX_NONE)
+            {
+                OutLocalNormal[EnterAxis] = -Step[EnterAxis];
+            }
+            else
+            {
+                // 起点就在方块里：取射线反方向上的主轴
+                const FVector Back = -Direction;
+                EnterAxis = FMath::Abs(Back.X) >= FMath::Abs(Back.Y) ? (FMath::Abs(Back.X) >= FMath::Abs(Back.Z) ? 0 : 2) : (FMath::Abs(Back.Y) >= FMath::Abs(Back.Z) ? 1 : 2);
+                OutLocalNormal[EnterAxis] = FMath::Sign(Back[EnterAxis]);
+            }
+            OutDistance = T * RayDirection.Size();
+            return true;
+        }
+
+        const int32 Axis = (NextT[0] < NextT[1]) ? (NextT[0] < NextT[2] ? 0 : 2) : (NextT[1] < NextT[2] ? 1 : 2);
+        Cell[Axis] += Step[Axis];
+        if (Cell[Axis] < 0 || Cell[Axis] >= Dimensions[Axis])
+        {
+            return false;
+        }
+        T = NextT[Axis];
+        NextT[Axis] += DeltaT[Axis];
+        EnterAxis = Axis;
+    }
+}
+
+void AMagicCubeActor::RotateLayer(ECubeAxis Axis, int32 LayerIndex, float Degrees)
+{
+    CancelSolveForPlayerMove();
+    PlayLayerRotation(Axis, LayerIndex, Degrees);
+}
+
+void AMagicCubeActor::PlayLayerRotation(ECubeAxis Axis, int32 LayerIndex, float Degrees)
+{
+    if (FMath::Abs(CurrentRotation.RemainingDegrees) > KINDA_SMALL_NUMBER)
+    {
+        return;
+    }
+    
+    int32 DimIndex = GetDimensionIndex(Axis);
+    int32 MaxLayer = Dimensions[DimIndex] - 1;
+    if (LayerIndex < 0 || LayerIndex > MaxLayer)
+    {
+        return;
+    }
+    
+    // 动画与拖拽共用同一份基准快照；拖拽松手后的回弹从当前拖拽角度继续
+    if (!bIsDraggingRotation || !(CurrentDragAxis == Axis && CurrentDragLayer == LayerIndex))
+    {
+        StartLayerRotation(Axis, LayerIndex);
+    }
+
+    // 落位角度按合法性表吸附，非正方形层不会停在 90° 上
+    CurrentRotation.Axis = Axis;
+    CurrentRotation.Layer = LayerIndex;
+    CurrentRotation.QuarterTurns = SnapToLegalQuarterTurns(Axis, LayerIndex, CurrentDragAngle + Degrees);
+    CurrentRotation.TargetAngle = CurrentRotation.QuarterTurns * 90.0f;
+    CurrentRotation.RemainingDegrees = CurrentRotation.TargetAngle - CurrentDragAngle;
+    CurrentRotation.AffectedCubies = CurrentDragCubies;
+
+    // 拖拽正好停在合法角度上时没有回弹动画，直接提交
+    if (FMath::Abs(CurrentRotation.RemainingDegrees) <= KINDA_SMALL_NUMBER)
+    {
+        FinishLayerRotation();
+    }
+}
+
+void AMagicCubeActor::BuildLayerTurnTable()
+{
+    // 层绕 Axis 转动时，横截面是另外两个轴的尺寸；只有正方形截面转 90° 后方块还在网格上
+    // 布局掩码里的空槽会随转动移动，不影响哪些角度合法，交给离散状态提交时兜底
+    LayerTurnMasks.Reset();
+    for (int32 AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+    {
+        const bool bSquare = Dimensions[(AxisIndex + 1) % 3] == Dimensions[(AxisIndex + 2) % 3];
+        const uint8 Mask = bSquare ? 0x0F : 0x05;
+        LayerTurnOffsets[AxisIndex] = LayerTurnMasks.Num();
+        for (int32 Layer = 0; Layer < Dimensions[AxisIndex]; Layer++)
+        {
+            LayerTurnMasks.Add(Mask);
+        }
+    }
+}
+
+uint8 AMagicCubeActor::GetLayerTurnMask(ECubeAxis Axis, int32 Layer) const
+{
+    const int32 DimIndex = GetDimensionIndex(Axis);
+    if (Layer < 0 || Layer >= Dimensions[DimIndex] || !LayerTurnMasks.IsValidIndex(LayerTurnOffsets[DimIndex] + Layer))
+    {
+        return 0;
+    }
+    return LayerTurnMasks[LayerTurnOffsets[DimIndex] + Layer];
+}
+
+bool AMagicCubeActor::IsLayerTurnLegal(ECubeAxis Axis, int32 Layer, int32 QuarterTurns) const
+{
+    return (GetLayerTurnMask(Axis, Layer) & (1u << MagicCube::NormalizeQuarterTurns(QuarterTurns))) != 0;
+}
+
+int32 AMagicCubeActor::SnapToLegalQuarterTurns(ECubeAxis Axis, int32 Layer, float Angle) const
+{
+    const uint8 Mask = GetLayerTurnMask(Axis, Layer);
+    const int32 Nearest = FMath::RoundToInt(Angle / 90.0f);
+    if (Mask & (1u << MagicCube::NormalizeQuarterTurns(Nearest)))
+    {
+        return Nearest;
+    }
+
+    // 合法角度至少每 180° 一个，所以只看相邻两个 90° 倍数
+    const int32 Lower = Nearest - 1;
+    const int32 Upper = Nearest + 1;
+    const bool bLowerLegal = (Mask & (1u << MagicCube::NormalizeQuarterTurns(Lower))) != 0;
+    const bool bUpperLegal = (Mask & (1u << MagicCube::NormalizeQuarterTurns(Upper))) != 0;
+    if (bLowerLegal && bUpperLegal)
+    {
+        const float LowerDistance = FMath::Abs(Lower * 90.0f - Angle);
+        const float UpperDistance = FMath::Abs(Upper * 90.0f - Angle);
+        if (FMath::IsNearlyEqual(LowerDistance, UpperDistance, KINDA_SMALL_NUMBER))
+        {
+            // 一样近时固定取不是整圈的一边：奇数个 90° 在非正方形层上总是变成半圈，而不是不转
+            return MagicCube::NormalizeQuarterTurns(Lower) != 0 ? Lower : Upper;
+        }
+        return LowerDistance < UpperDistance ? Lower : Upper;
+    }
+    return bLowerLegal ? Lower : (bUpperLegal ? Upper : 0);
+}
+
+void AMagicCubeActor::SetLayerRotation(ECubeAxis Axis, int32 Layer, float Angle)
+{
+    if (IsRotationAnimating())
+    {
+        return;
+    }
+
+    // 如果当前拖拽数据不匹配，则初始化一次拖拽基准
+    if (!bIsDraggingRotation || !(CurrentDragAxis == Axis && CurrentDragLayer == Layer))
+    {
+        BeginLayerRotation(Axis, Layer);
+    }
+    CurrentDragAngle = Angle;
+
+    ApplyRotationToInstances(Angle);
+}
+
+TArrayView<const int32> AMagicCubeActor::CollectLayerInstances(ECubeAxis Axis, int32 Layer)
+{
+    // 直接取离散状态维护的层索引表；所有方块都有实例时 O(1) 且不分配
+    // 剔除了内部方块时每次开始转动过滤一遍，之后每帧只处理有实例的方块
+    const MagicCube::FIndexSpan LayerCubies = CubeState.GetLayerCubies(GetDimensionIndex(Axis), Layer);
+    if (InstanceCubies.Num() == CubeState.GetNumCubies())
+    {
+        return MakeArrayView(LayerCubies.Data, LayerCubies.Count);
+    }
+
+    CurrentDragVisibleCubies.Reset(LayerCubies.Count);
+    for (int32 Cubie : LayerCubies)
+    {
+        if (CubieInstances[Cubie] != INDEX_NONE)
+        {
+            CurrentDragVisibleCubies.Add(Cubie);
+        }
+    }
+    return MakeArrayView(CurrentDragVisibleCubies);
+}
+
+void AMagicCubeActor::ApplyRotationToInstances(float Angle)
+{
+    SCOPE_CYCLE_COUNTER(STAT_MagicCubeLayerUpdate);
+
+    // 基准变换和枢轴在 BeginLayerRotation 里只取一次，这里每个实例只写一次
+    const FQuat RotQuat = GetLayerRotationQuat(CurrentDragAxis, Angle);
+
+    // 材质驱动：实例停在基准变换上，每帧只改一个角度参数，和层大小无关
+    if (IsShaderLayerRotationActive())
+    {
+        for (UMaterialInstanceDynamic* Material : LayerRotationMaterials)
+        {
+            Material->SetScalarParameterValue(LayerRotationAngleParam, Angle);
+        }
+        UpdateTopPartsForLayerRotation(RotQuat);
+        return;
+    }
+
+    for (int32 i = 0; i < CurrentDragCubies.Num(); i++)
+    {
+        const FTransform& BaseTransform = CurrentDragBaseTransforms[i];
+        const FVector LocalOffset = BaseTransform.GetLocation() - CurrentDragPivot;
+
+        const FIntPoint& BatchSlot = CurrentDragBatchSlots[i];
+        FTransform& NewTransform = CurrentDragBatchRuns[BatchSlot.X].Transforms[BatchSlot.Y];
+        NewTransform.SetLocation(CurrentDragPivot + RotQuat.RotateVector(LocalOffset));
+        NewTransform.SetRotation(RotQuat * BaseTransform.GetRotation());
+        NewTransform.SetScale3D(BaseTransform.GetScale3D());
+    }
+
+    FlushLayerBatchRuns();
+    UpdateTopPartsForLayerRotation(RotQuat);
+}
+
+void AMagicCubeActor::BuildLayerBatchRuns()
+{
+    // 按实例下标排序后切成连续区段；每帧只改区段缓冲里的对应元素
+    TArray<int32> Order;
+    Order.Reserve(CurrentDragCubies.Num());
+    for (int32 i = 0; i < CurrentDragCubies.Num(); i++)
+    {
+        Order.Add(i);
+    }
+    Order.Sort([this](int32 A, int32 B) { return CubieInstances[CurrentDragCubies[A]] < CubieInstances[CurrentDragCubies[B]]; });
+
+    CurrentDragBatchRuns.Reset();
+    CurrentDragBatchSlots.SetNumUninitialized(CurrentDragCubies.Num());
+    for (int32 i : Order)
+    {
+        const int32 Index = CubieInstances[CurrentDragCubies[i]];
+        FInstanceBatchRun* Run = CurrentDragBatchRuns.Num() > 0 ? &CurrentDragBatchRuns.Last() : nullptr;
+        const int32 RunEnd = Run ? Run->StartIndex + Run->Transforms.Num() : 0;
+        if (!Run || Index - RunEnd > MaxInstanceBatchGap)
+        {
+            Run = &CurrentDragBatchRuns.AddDefaulted_GetRef();
+            Run->StartIndex = Index;
+        }
+        else
+        {
+            // 空隙里是静止的实例，已吸附在离散状态上
+            for (int32 GapIndex = RunEnd; GapIndex < Index; GapIndex++)
+            {
+                Run->Transforms.Add(GetCubieTransform(InstanceCubies[GapIndex]));
+            }
+        }
+        CurrentDragBatchSlots[i] = FIntPoint(CurrentDragBatchRuns.Num() - 1, Run->Transforms.Num());
+        Run->Transforms.Add(CurrentDragBaseTransforms[i]);
+    }
+}
+
+void AMagicCubeActor::FlushLayerBatchRuns()
+{
+    // 每段一次批量提交，渲染状态整层只刷新一次
+    for (const FInstanceBatchRun& Run : CurrentDragBatchRuns)
+    {
+        InstancedMesh->BatchUpdateInstancesTransforms(Run.StartIndex, Run.Transforms, /*bWorldSpace=*/ false, /*bMarkRenderStateDirty=*/ false, /*bTeleport=*/ true);
+    }
+    InstancedMesh->MarkRenderStateDirty();
+}
+
+void AMagicCubeActor::UpdateTopPartsForLayerRotation(const FQuat& RotQuat, bool bCommitted)
+{
+    // 顶面部件与方块同在 Root 的局部空间，围绕同一个枢轴旋转
+    // 部件跟着驮它的方块走，不管方块现在在哪一层：只看转动层里的方块，按方块编号直接查到部件，O(层大小)
+    TArray<bool, TInlineAllocator<8>> GroupDirty;
+    GroupDirty.Init(false, TopPartInstancedMeshes.Num());
+    for (int32 i = 0; i < CurrentDragCubies.Num(); i++)
+    {
+        const int32 Cubie = CurrentDragCubies[i];
+        const int32 PartIndex = CubieTopParts.IsValidIndex(Cubie) ? CubieTopParts[Cubie] : INDEX_NONE;
+        if (PartIndex == INDEX_NONE || !CurrentDragTopPartBaseTransforms.IsValidIndex(i))
+        {
+            continue;
+        }
+
+        FTransform NewRelativeTransform;
+        if (bCommitted)
+        {
+            NewRelativeTransform = GetTopPartTransform(PartIndex);
+        }
+        else
+        {
+            const FTransform& BaseTransform = CurrentDragTopPartBaseTransforms[i];
+            const FVector LocalOffset = BaseTransform.GetLocation() - CurrentDragPivot;
+            NewRelativeTransform.SetLocation(CurrentDragPivot + RotQuat.RotateVector(LocalOffset));
+            NewRelativeTransform.SetRotation(RotQuat * BaseTransform.GetRotation());
+            NewRelativeTransform.SetScale3D(BaseTransform.GetScale3D());
+        }
+
+        const FTopPart& Part = TopParts[PartIndex];
+        TopPartInstancedMeshes[Part.Group]->UpdateInstanceTransform(Part.Instance, NewRelativeTransform, /*bWorldSpace=*/ false, /*bMarkRenderStateDirty=*/ false, /*bTeleport=*/ true);
+        GroupDirty[Part.Group] = true;
+    }
+    for (int32 Group = 0; Group < TopPartInstancedMeshes.Num(); Group++)
+    {
+        if (GroupDirty[Group])
+        {
+            TopPartInstancedMeshes[Group]->MarkRenderStateDirty();
+        }
+    }
+}
+
+
+int32 AMagicCubeActor::GetDimensionIndex(ECubeAxis Axis) const
+{
+    switch (Axis)
+    {
+        case ECubeAxis::X: return 0;
+        case ECubeAxis::Y: return 1;
+        case ECubeAxis::Z: return 2;
+    }
+    return 0;
+}
+
+void AMagicCubeActor::Scramble(int32 Moves)
+{
+    CancelSolveForPlayerMove();
+    for (int32 i = 0; i < Moves; i++)
+    {
+        ECubeAxis RandomAxis = static_cast<ECubeAxis>(FMath::RandRange(0, 2));
+        int32 RandomLayer = FMath::RandRange(0, Dimensions[GetDimensionIndex(RandomAxis)] - 1);
+        int32 RandomTurns = (FMath::RandBool() ? 1 : -1);
+        EnqueueMove(RandomAxis, RandomLayer, RandomTurns);
+    }
+}
+
+void AMagicCubeActor::QueueMove(ECubeAxis Axis, int32 Layer, int32 QuarterTurns)
+{
+    CancelSolveForPlayerMove();
+    EnqueueMove(Axis, Layer, QuarterTurns);
+}
+
+void AMagicCubeActor::EnqueueMove(ECubeAxis Axis, int32 Layer, int32 QuarterTurns)
+{
+    if (Layer < 0 || Layer >= Dimensions[GetDimensionIndex(Axis)])
     {
-        FTransform Transform;
-        InstancedMesh->GetInstanceTransform(i, Transform, true);
-        InitialTransforms.Add(Transform);
+        return;
     }
-}
 
-void AMagicCubeActor::Tick(float DeltaTime)
-{
-    Super::Tick(DeltaTime);
-    
-    if (FMath::Abs(CurrentRotation.RemainingDegrees) > KINDA_SMALL_NUMBER)
+    // 入队前就归一并换成合法转动（-1..2），等价的写法入队结果相同，后面的合并结果也一定合法
+    QuarterTurns = MagicCube::NormalizeSignedQuarterTurns(SnapToLegalQuarterTurns(Axis, Layer, MagicCube::NormalizeSignedQuarterTurns(QuarterTurns) * 90.0f));
+
+    // 同轴不同层的转动可交换，所以向前越过同轴转动找同一层合并：R L R' -> L，R R -> R2
+    for (int32 i = PendingMoves.Num() - 1; i >= PendingMoveHead && PendingMoves[i].Axis == Axis; i--)
     {
-        float DeltaRotation = FMath::Sign(CurrentRotation.RemainingDegrees) *
-            FMath::Min(RotationSpeed * DeltaTime, FMath::Abs(CurrentRotation.RemainingDegrees));
-        
-        ApplyRotationToInstances(DeltaRotation);
-        CurrentRotation.RemainingDegrees -= DeltaRotation;
-        
-        if (FMath::IsNearlyZero(CurrentRotation.RemainingDegrees))
+        FMagicCubeMove& Pending = PendingMoves[i];
+        if (Pending.Layer == Layer)
         {
-            // 更新全局初始变换：对于每个受影响的实例，保存最新状态
-            for (int32 Index : CurrentRotation.AffectedInstances)
+            const int32 Turns = (((Pending.QuarterTurns + QuarterTurns) % 4) + 4) % 4;
+            if (Turns == 0)
             {
-                FTransform T;
-                InstancedMesh->GetInstanceTransform(Index, T, true);
-                if (InitialTransforms.IsValidIndex(Index))
-                {
-                    InitialTransforms[Index] = T;
-                }
+                PendingMoves.RemoveAt(i);
             }
-            
-            // 对顶面部件，确保 TopPartInitialTransforms 数组与 TopPartComponents 数量匹配
-            if (CurrentRotation.Axis == ECubeAxis::Z && CurrentRotation.Layer == Dimensions[2]-1)
+            else
             {
-                if (TopPartInitialTransforms.Num() != TopPartComponents.Num())
-                {
-                    TopPartInitialTransforms.Empty();
-                    for (int32 i = 0; i < TopPartComponents.Num(); i++)
-                    {
-                        if (TopPartComponents[i])
-                            TopPartInitialTransforms.Add(TopPartComponents[i]->GetRelativeTransform());
-                    }
-                }
-                else
-                {
-                    for (int32 i = 0; i < TopPartComponents.Num(); i++)
-                    {
-                        if (TopPartComponents[i])
-                            TopPartInitialTransforms[i] = TopPartComponents[i]->GetRelativeTransform();
-                    }
-                }
+                Pending.QuarterTurns = (Turns == 3) ? -1 : Turns;
             }
-            
-            OnRotationComplete.Broadcast(CurrentRotation.Axis, CurrentRotation.Layer);
-            EndLayerRotationDrag();
+            return;
         }
     }
+
+    const int32 Turns = ((QuarterTurns % 4) + 4) % 4;
+    if (Turns != 0)
+    {
+        FMagicCubeMove Move;
+        Move.Axis = Axis;
+        Move.Layer = Layer;
+        Move.QuarterTurns = (Turns == 3) ? -1 : Turns;
+        PendingMoves.Add(Move);
+    }
 }
 
-void AMagicCubeActor::InitializeCube()
+void AMagicCubeActor::QueueMoves(const TArray<FMagicCubeMove>& Moves)
 {
-    float ComputedScale = 1.0f;
-    if (CubeMesh)
+    CancelSolveForPlayerMove();
+    for (const FMagicCubeMove& Move : Moves)
     {
-        FBoxSphereBounds MeshBounds = CubeMesh->GetBounds();
-        float MeshSize = MeshBounds.BoxExtent.GetMax() * 2.0f;
-        if (MeshSize > KINDA_SMALL_NUMBER)
-        {
-            ComputedScale = BlockSize / MeshSize;
-        }
+        EnqueueMove(Move.Axis, Move.Layer, Move.QuarterTurns);
     }
-    else
+}
+
+TArray<FMagicCubeMove> AMagicCubeActor::Solve() const
+{
+    TArray<FMagicCubeMove> Result;
+    if (CubeState.GetFixedOrder() != 2)
     {
-        ComputedScale = BlockSize / 100.0f;
+        return Result;
     }
-    
-    for (int32 z = 0; z < Dimensions[2]; z++)
+
+    std::vector<MagicCube::FLayerTurn> Solution;
+    if (FMagicCubeSolverTables::GetPocketCubeSolver().Solve(CubeState, Solution))
     {
-        for (int32 y = 0; y < Dimensions[1]; y++)
+        Result.Reserve(Solution.size());
+        for (const MagicCube::FLayerTurn& Turn : Solution)
         {
-            for (int32 x = 0; x < Dimensions[0]; x++)
-            {
-                int32 LinearIndex = x + y * Dimensions[0] + z * Dimensions[0] * Dimensions[1];
-                bool bPlaceBlock = LayoutMask.IsValidIndex(LinearIndex) ? LayoutMask[LinearIndex] : true;
-                if (bPlaceBlock)
-                {
-                    FTransform Transform;
-                    Transform.SetLocation(CalculatePosition(x, y, z));
-                    Transform.SetScale3D(FVector(ComputedScale));
-                    InstancedMesh->AddInstance(Transform);
-                }
-            }
+            Result.Add(ToMagicCubeMove(Turn));
         }
     }
+    return Result;
 }
 
-FVector AMagicCubeActor::CalculatePosition(int32 x, int32 y, int32 z) const
+void AMagicCubeActor::SolveAsync(int32 TargetLength)
 {
-    float OffsetX = (x - (Dimensions[0] - 1) / 2.0f) * BlockSize;
-    float OffsetY = (y - (Dimensions[1] - 1) / 2.0f) * BlockSize;
-    float OffsetZ = (z - (Dimensions[2] - 1) / 2.0f) * BlockSize;
-    return FVector(OffsetX, OffsetY, OffsetZ);
+    // 快照在游戏线程上复制，工作线程只读这份副本
+    TSharedPtr<FMagicCubeSolveJob, ESPMode::ThreadSafe> Job = StartSolveJob(false);
+    UE::Tasks::Launch(UE_SOURCE_LOCATION, [Job, Snapshot = CubeState, TargetLength]()
+    {
+        std::vector<MagicCube::FLayerTurn> Solution;
+        Job->bSucceeded = FMagicCubeSolverTasks::Solve(Snapshot, TargetLength, Solution, &Job->Control);
+        Job->Solution.Reserve(Solution.size());
+        for (const MagicCube::FLayerTurn& Turn : Solution)
+        {
+            Job->Solution.Add(ToMagicCubeMove(Turn));
+        }
+        Job->bFinished = true;
+    });
 }
 
-int32 AMagicCubeActor::GetLinearIndex(int32 x, int32 y, int32 z) const
+bool AMagicCubeActor::StartStreamingSolve()
 {
-    return x + y * Dimensions[0] + z * Dimensions[0] * Dimensions[1];
-}
+    const int32 Order = Facelets.GetOrder();
+    if (Order < MagicCube::FReductionSolver::MinOrder || CubeState.GetNumCubies() != Order * Order * Order || bIsDraggingRotation)
+    {
+        return false;
+    }
 
-void AMagicCubeActor::RotateLayer(ECubeAxis Axis, int32 LayerIndex, float Degrees)
-{
+    CancelSolve();
     if (FMath::Abs(CurrentRotation.RemainingDegrees) > KINDA_SMALL_NUMBER)
     {
-        return;
+        FinishLayerRotation();
     }
-    
-    int32 DimIndex = GetDimensionIndex(Axis);
-    int32 MaxLayer = Dimensions[DimIndex] - 1;
-    if (LayerIndex < 0 || LayerIndex > MaxLayer)
+    ClearPendingMoves();
+    bPendingMovesStreamed = true;
+
+    TSharedPtr<FMagicCubeSolveJob, ESPMode::ThreadSafe> Job = StartSolveJob(true);
+    UE::Tasks::Launch(UE_SOURCE_LOCATION, [Job, Snapshot = Facelets]()
     {
-        return;
-    }
-    
-    CurrentRotation.Axis = Axis;
-    CurrentRotation.Layer = LayerIndex;
-    CurrentRotation.RemainingDegrees = Degrees;
-    CollectLayerInstances(Axis, LayerIndex, CurrentRotation.AffectedInstances);
+        Job->bSucceeded = FMagicCubeSolverTasks::SolveReduction(Snapshot, [&Job](const MagicCube::FLayerTurn& Turn) { Job->StreamedMoves.Enqueue(Turn); }, &Job->Control);
+        Job->bFinished = true;
+    });
+    return true;
 }
 
-void AMagicCubeActor::SetLayerRotation(ECubeAxis Axis, int32 Layer, float Angle)
+TSharedPtr<FMagicCubeSolveJob, ESPMode::ThreadSafe> AMagicCubeActor::StartSolveJob(bool bStreaming)
 {
-    // 如果当前拖拽数据不匹配，则初始化一次拖拽基准
-    if (!bIsDraggingRotation || !(CurrentDragAxis == Axis && CurrentDragLayer == Layer))
+    CancelSolve();
+    SolveJob = MakeShared<FMagicCubeSolveJob, ESPMode::ThreadSafe>();
+    SolveJob->bStreaming = bStreaming;
+    SolveJob->SnapshotMoveCount = CommittedMoveCount;
+    return SolveJob;
+}
+
+void AMagicCubeActor::CancelSolve()
+{
+    if (SolveJob.IsValid())
     {
-        BeginLayerRotation(Axis, Layer);
+        // 工作线程持有自己的引用，这里只发取消请求，不等它结束
+        SolveJob->Control.bCancel = true;
+        SolveJob.Reset();
     }
+}
 
-    // 1. 计算旋转轴（与RotateLayer一致）
-    FVector RotationAxis;
-    switch (Axis)
+void AMagicCubeActor::CancelSolveForPlayerMove()
+{
+    CancelSolve();
+    if (bPendingMovesStreamed)
     {
-        case ECubeAxis::X: RotationAxis = FVector::ForwardVector; break;
-        case ECubeAxis::Y: RotationAxis = FVector::RightVector;   break;
-        case ECubeAxis::Z: RotationAxis = FVector::UpVector;      break;
-        default:           RotationAxis = FVector::ZeroVector;    break;
+        ClearPendingMoves();
     }
-    FQuat RotQuat(RotationAxis, FMath::DegreesToRadians(Angle));
+}
 
-    // 2. 计算世界空间中的枢轴点（与RotateLayer一致）
-    FVector Pivot = FVector::ZeroVector;
-    for (const FTransform& BaseTransform : CurrentDragBaseTransforms)
+void AMagicCubeActor::UpdateSolveJob()
+{
+    // 广播回调里可能取消或重新开始求解，这里持有本次的引用
+    TSharedPtr<FMagicCubeSolveJob, ESPMode::ThreadSafe> Job = SolveJob;
+    if (!Job.IsValid())
     {
-        Pivot += BaseTransform.GetLocation();
+        return;
     }
-    Pivot /= CurrentDragBaseTransforms.Num();
 
-    // 3. 应用旋转到实例（世界空间计算）
-    for (int32 i = 0; i < CurrentDragAffectedInstances.Num(); i++)
+    // 普通求解的快照之后又提交了转动，结果已经对不上当前状态，直接丢弃
+    if (!Job->bStreaming && Job->SnapshotMoveCount != CommittedMoveCount)
     {
-        int32 idx = CurrentDragAffectedInstances[i];
-        if (CurrentDragBaseTransforms.IsValidIndex(i))
-        {
-            FTransform BaseTransform = CurrentDragBaseTransforms[i];
-            FVector LocalOffset = BaseTransform.GetLocation() - Pivot;
-            FVector NewWorldPos = Pivot + RotQuat.RotateVector(LocalOffset);
-            FQuat NewWorldRot = RotQuat * BaseTransform.GetRotation();
-
-            FTransform NewTransform;
-            NewTransform.SetLocation(NewWorldPos);
-            NewTransform.SetRotation(NewWorldRot);
-            NewTransform.SetScale3D(BaseTransform.GetScale3D());
+        UE_LOG(LogTemp, Log, TEXT("MagicCube: state changed while solving, discarding stale solve"));
+        CancelSolve();
+        return;
+    }
 
-            InstancedMesh->UpdateInstanceTransform(idx, NewTransform, true);
-        }
+    // 先读完成标志再取结果，完成前写入的内容都能在这一帧取到
+    const bool bFinished = Job->bFinished;
+    MagicCube::FLayerTurn Turn;
+    while (Job->StreamedMoves.Dequeue(Turn))
+    {
+        const FMagicCubeMove Move = ToMagicCubeMove(Turn);
+        EnqueueMove(Move.Axis, Move.Layer, Move.QuarterTurns);
     }
 
-    // 4. 同步更新顶面部件（关键修正部分）
-    int32 TopLayerStartIndex = Dimensions[0] * Dimensions[1] * (Dimensions[2]-1);
-    for (int32 i = 0; i < TopPartComponents.Num(); i++)
+    const int64 Nodes = Job->Control.Nodes.load(std::memory_order_relaxed);
+    const int32 Depth = Job->Control.Depth.load(std::memory_order_relaxed);
+    if (Nodes != Job->ReportedNodes || Depth != Job->ReportedDepth)
     {
-        int32 BlockIndex = TopLayerStartIndex + i;
-        if (CurrentDragAffectedInstances.Contains(BlockIndex) && 
-            CurrentDragTopPartBaseTransforms.IsValidIndex(i))
-        {
-            UStaticMeshComponent* Comp = TopPartComponents[i];
-            if (Comp)
-            {
-                // 获取顶面部件的世界空间初始位置（相对于RootComponent）
-                FTransform InitialWorldTransform = CurrentDragTopPartBaseTransforms[i] * RootComponent->GetComponentTransform();
-                
-                // 计算相对于枢轴点的偏移
-                FVector LocalOffset = InitialWorldTransform.GetLocation() - Pivot;
-                
-                // 应用旋转
-                FVector NewWorldPos = Pivot + RotQuat.RotateVector(LocalOffset);
-                FQuat NewWorldRot = RotQuat * InitialWorldTransform.GetRotation();
-                
-                // 转换回相对RootComponent的变换
-                FTransform NewWorldTransform;
-                NewWorldTransform.SetLocation(NewWorldPos);
-                NewWorldTransform.SetRotation(NewWorldRot);
-                NewWorldTransform.SetScale3D(InitialWorldTransform.GetScale3D());
-                
-                FTransform NewRelativeTransform = NewWorldTransform.GetRelativeTransform(RootComponent->GetComponentTransform());
-                Comp->SetRelativeTransform(NewRelativeTransform);
-            }
-        }
+        Job->ReportedNodes = Nodes;
+        Job->ReportedDepth = Depth;
+        OnSolveProgress.Broadcast(Nodes, Depth);
     }
 
-    InstancedMesh->MarkRenderStateDirty();
+    // 先清掉再广播，回调里可以直接开始下一次求解或把结果放进队列
+    if (bFinished && SolveJob == Job)
+    {
+        SolveJob.Reset();
+        OnSolutionReady.Broadcast(Job->bSucceeded, Job->Solution);
+    }
 }
 
-void AMagicCubeActor::CollectLayerInstances(ECubeAxis Axis, int32 Layer, TArray<int32>& OutInstances)
+void AMagicCubeActor::ClearPendingMoves()
 {
-    OutInstances.Empty();
-    int32 Total = InstancedMesh->GetInstanceCount();
-    int32 DimIdx = GetDimensionIndex(Axis);
-
-    // 在组件自身空间里，这一层对应的理想坐标
-    float CenterOffset = (Dimensions[DimIdx] - 1) * 0.5f;
-    float TargetLocal = (Layer - CenterOffset) * BlockSize;
-    const float Tol = 0.01f;
-
-    for (int32 i = 0; i < Total; ++i)
-    {
-        // 直接拿「组件局部」Transform
-        FTransform LocalTr;
-        InstancedMesh->GetInstanceTransform(i, LocalTr, /*bWorldSpace=*/false);
-
-        float V = (Axis == ECubeAxis::X ? LocalTr.GetLocation().X :
-                   Axis == ECubeAxis::Y ? LocalTr.GetLocation().Y :
-                                          LocalTr.GetLocation().Z);
+    PendingMoves.Reset();
+    PendingMoveHead = 0;
+    bPendingMovesStreamed = false;
+}
 
-        if (FMath::Abs(V - TargetLocal) <= Tol)
-        {
-            OutInstances.Add(i);
-        }
-    }
+int32 AMagicCubeActor::ApplyMovesInstant(const TArray<FMagicCubeMove>& Moves)
+{
+    CancelSolveForPlayerMove();
+    return CommitMovesInstant(Moves);
 }
 
-void AMagicCubeActor::ApplyRotationToInstances(float DeltaDegrees)
+int32 AMagicCubeActor::CommitMovesInstant(const TArray<FMagicCubeMove>& Moves)
 {
-    // 1. 计算旋转轴
-    FVector RotationAxis;
-    switch (CurrentRotation.Axis)
+    // 正在播放的转动先直接落位，正在拖拽的层由下面的整体重建复位
+    if (FMath::Abs(CurrentRotation.RemainingDegrees) > KINDA_SMALL_NUMBER)
     {
-        case ECubeAxis::X: RotationAxis = FVector::ForwardVector; break;
-        case ECubeAxis::Y: RotationAxis = FVector::RightVector;   break;
-        case ECubeAxis::Z: RotationAxis = FVector::UpVector;      break;
-        default:           RotationAxis = FVector::ZeroVector;    break;
+        FinishLayerRotation();
     }
-    FQuat DeltaQuat(RotationAxis, FMath::DegreesToRadians(DeltaDegrees));
-
-    // 2. 先算出这一轮所有实例的世界质心（Pivot）
-    FVector Pivot = FVector::ZeroVector;
-    for (int32 Index : CurrentRotation.AffectedInstances)
+    else if (bIsDraggingRotation)
     {
-        FTransform Tr;
-        InstancedMesh->GetInstanceTransform(Index, Tr, /*bWorldSpace=*/ true);
-        Pivot += Tr.GetLocation();
+        EndLayerRotationDrag();
     }
-    Pivot /= CurrentRotation.AffectedInstances.Num();
 
-    // 3. 围绕 Pivot 做旋转
-    for (int32 Index : CurrentRotation.AffectedInstances)
+    InstantTurns.Reset(Moves.Num());
+    for (const FMagicCubeMove& Move : Moves)
     {
-        // 拿到当前 world-space Transform
-        FTransform Tr;
-        InstancedMesh->GetInstanceTransform(Index, Tr, /*bWorldSpace=*/ true);
+        MagicCube::FLayerTurn& Turn = InstantTurns.AddDefaulted_GetRef();
+        Turn.AxisIndex = GetDimensionIndex(Move.Axis);
+        Turn.Layer = Move.Layer;
+        Turn.QuarterTurns = MagicCube::NormalizeSignedQuarterTurns(SnapToLegalQuarterTurns(Move.Axis, Move.Layer, MagicCube::NormalizeSignedQuarterTurns(Move.QuarterTurns) * 90.0f));
+    }
 
-        // 移到枢轴原点、旋转、再移回
-        FVector LocalOffset = Tr.GetLocation() - Pivot;
-        FVector NewWorldPos = Pivot + DeltaQuat.RotateVector(LocalOffset);
-        FQuat   NewWorldRot = DeltaQuat * Tr.GetRotation();
+    const int32 Applied = CubeState.ApplyMoves(InstantTurns.GetData(), InstantTurns.Num());
+    Facelets.ApplyMoves(InstantTurns.GetData(), InstantTurns.Num());
+    CommittedMoveCount += Applied;
+    RefreshAllTransforms();
+    if (UpdateSolvedState())
+    {
+        OnCubeSolved.Broadcast();
+    }
+    return Applied;
+}
 
-        FTransform NewTr;
-        NewTr.SetLocation(NewWorldPos);
-        NewTr.SetRotation(NewWorldRot);
-        NewTr.SetScale3D(Tr.GetScale3D());
+bool AMagicCubeActor::UpdateSolvedState()
+{
+    const bool bWasSolved = bIsSolved;
+    bIsSolved = CubeState.IsSolved();
+    return bIsSolved && !bWasSolved;
+}
 
-        InstancedMesh->UpdateInstanceTransform(Index, NewTr, /*bWorldSpace=*/ true, /*bMarkRenderStateDirty=*/ false);
+void AMagicCubeActor::ProcessPendingMoves()
+{
+    // 正在播放动画或玩家正在拖拽时不出队
+    if (GetPendingMoveCount() == 0 || FMath::Abs(CurrentRotation.RemainingDegrees) > KINDA_SMALL_NUMBER || bIsDraggingRotation)
+    {
+        return;
     }
 
-    // 4. 同步顶面部件（若有），同样围绕相同的 Pivot 做旋转
-    int32 TopLayerStartIndex = Dimensions[0] * Dimensions[1] * (Dimensions[2] - 1);
-    for (int32 i = 0; i < TopPartComponents.Num(); i++)
+    if (bInstantMoves)
     {
-        int32 BlockIndex = TopLayerStartIndex + i;
-        if (CurrentRotation.AffectedInstances.Contains(BlockIndex))
+        // 全部一次性提交，再逐步补发完成事件
+        TArray<FMagicCubeMove> Moves(PendingMoves.GetData() + PendingMoveHead, PendingMoves.Num() - PendingMoveHead);
+        ClearPendingMoves();
+        CommitMovesInstant(Moves);
+        for (const FMagicCubeMove& Move : Moves)
         {
-            UStaticMeshComponent* Comp = TopPartComponents[i];
-            if (Comp)
-            {
-                // 取相对 Root 的世界 Transform
-                FTransform CompWorldTr = Comp->GetComponentTransform();
-                FVector LocalOffset = CompWorldTr.GetLocation() - Pivot;
-                FVector NewWorldPos = Pivot + DeltaQuat.RotateVector(LocalOffset);
-                FQuat   NewWorldRot = DeltaQuat * CompWorldTr.GetRotation();
-
-                // 转回相对 Root 的相对变换
-                FTransform NewRel = CompWorldTr;
-                NewRel.SetLocation(NewWorldPos);
-                NewRel.SetRotation(NewWorldRot);
-                Comp->SetWorldTransform(NewRel);
-            }
+            OnRotationComplete.Broadcast(Move.Axis, Move.Layer);
         }
     }
+    else
+    {
+        const FMagicCubeMove Move = PendingMoves[PendingMoveHead++];
+        PlayLayerRotation(Move.Axis, Move.Layer, Move.QuarterTurns * 90.0f);
+    }
 
-    // 5. 最后一次性刷新渲染
-    InstancedMesh->MarkRenderStateDirty();
+    if (PendingMoveHead >= PendingMoves.Num())
+    {
+        ClearPendingMoves();
+    }
 }
 
-
-int32 AMagicCubeActor::GetDimensionIndex(ECubeAxis Axis) const
+void AMagicCubeActor::RefreshAllTransforms()
 {
-    switch (Axis)
+    // 所有方块的最终变换只算一次，整体一次批量提交
+    RefreshTransforms.SetNum(InstanceCubies.Num(), EAllowShrinking::No);
+    for (int32 Instance = 0; Instance < RefreshTransforms.Num(); Instance++)
     {
-        case ECubeAxis::X: return 0;
-        case ECubeAxis::Y: return 1;
-        case ECubeAxis::Z: return 2;
+        RefreshTransforms[Instance] = GetCubieTransform(InstanceCubies[Instance]);
+    }
+    if (RefreshTransforms.Num() > 0)
+    {
+        InstancedMesh->BatchUpdateInstancesTransforms(0, RefreshTransforms, /*bWorldSpace=*/ false, /*bMarkRenderStateDirty=*/ true, /*bTeleport=*/ true);
+    }
+    if (IsShaderLayerRotationActive())
+    {
+        WriteCubieCustomData();
+    }
+
+    // 顶面部件同样每组一次批量提交
+    TopPartGroupTransforms.SetNum(TopPartInstancedMeshes.Num());
+    for (int32 Group = 0; Group < TopPartInstancedMeshes.Num(); Group++)
+    {
+        TopPartGroupTransforms[Group].SetNum(TopPartInstancedMeshes[Group]->GetInstanceCount(), EAllowShrinking::No);
+    }
+    for (int32 i = 0; i < TopParts.Num(); i++)
+    {
+        TopPartGroupTransforms[TopParts[i].Group][TopParts[i].Instance] = GetTopPartTransform(i);
+    }
+    for (int32 Group = 0; Group < TopPartInstancedMeshes.Num(); Group++)
+    {
+        if (TopPartGroupTransforms[Group].Num() > 0)
+        {
+            TopPartInstancedMeshes[Group]->BatchUpdateInstancesTransforms(0, TopPartGroupTransforms[Group], /*bWorldSpace=*/ false, /*bMarkRenderStateDirty=*/ true, /*bTeleport=*/ true);
+        }
     }
-    return 0;
 }
 
-void AMagicCubeActor::Scramble(int32 Moves)
+FTransform AMagicCubeActor::GetTopPartTransform(int32 PartIndex) const
 {
-    for (int32 i = 0; i < Moves; i++)
+    // 部件随其下方方块整体刚体运动：相对方块初始位置的偏移按方块朝向旋转
+    const int32 BlockIndex = TopParts.IsValidIndex(PartIndex) ? TopParts[PartIndex].Cubie : INDEX_NONE;
+    if (!TopPartHomeTransforms.IsValidIndex(PartIndex) || BlockIndex < 0 || BlockIndex >= CubeState.GetNumCubies())
     {
-        ECubeAxis RandomAxis = static_cast<ECubeAxis>(FMath::RandRange(0, 2));
-        int32 RandomLayer = FMath::RandRange(0, Dimensions[GetDimensionIndex(RandomAxis)] - 1);
-        float RandomAngle = (FMath::RandBool() ? 90.0f : -90.0f);
-        RotateLayer(RandomAxis, RandomLayer, RandomAngle);
+        return FTransform::Identity;
     }
+
+    const FTransform& HomeTransform = TopPartHomeTransforms[PartIndex];
+    const MagicCube::FCoords HomeCoords = CubeState.GetSlotCoords(CubeState.GetCubieHomeSlot(BlockIndex));
+    const MagicCube::FCoords Coords = CubeState.GetSlotCoords(CubeState.GetCubieSlot(BlockIndex));
+    const FQuat Orientation = ToQuat(MagicCube::GetOrientationQuat(CubeState.GetCubieOrientation(BlockIndex)));
+    const FVector HomeOffset = HomeTransform.GetLocation() - CalculatePosition(HomeCoords.X, HomeCoords.Y, HomeCoords.Z);
+
+    return FTransform(
+        Orientation * HomeTransform.GetRotation(),
+        CalculatePosition(Coords.X, Coords.Y, Coords.Z) + Orientation.RotateVector(HomeOffset),
+        HomeTransform.GetScale3D());
 }
 
 void AMagicCubeActor::ResetCube()
 {
-    InstancedMesh->ClearInstances();
-    for (const FTransform& Transform : InitialTransforms)
-    {
-        InstancedMesh->AddInstance(Transform);
-    }
+    // 回到还原状态：正在播放、拖拽和排队的转动全部丢弃，不提交
+    CancelSolve();
+    CurrentRotation.RemainingDegrees = 0.0f;
+    EndLayerRotationDrag();
+    ClearPendingMoves();
+
+    CubeState.Reset();
+    Facelets.Reset();
+    bIsSolved = CubeState.IsSolved();
+    CommittedMoveCount++;
+    HomeStateMoveCount = CommittedMoveCount;
+
+    // 实例不增删，下标保持不变；方块和顶面部件各自一次批量覆盖变换
+    RefreshAllTransforms();
 }
 
 void AMagicCubeActor::InitializeTopParts()
 {
-    for (UStaticMeshComponent* Comp : TopPartComponents)
+    // 已有的分组组件按网格复用，组件内的实例按顺序复用，只改变了的部分
+    TMap<UStaticMesh*, UInstancedStaticMeshComponent*> ExistingGroups;
+    for (UInstancedStaticMeshComponent* Comp : TopPartInstancedMeshes)
     {
         if (Comp)
         {
-            Comp->DestroyComponent();
+            ExistingGroups.Add(Comp->GetStaticMesh(), Comp);
         }
     }
-    TopPartComponents.Empty();
-    TopPartInitialTransforms.Empty();
-    
-    int32 ExpectedCount = Dimensions[0] * Dimensions[1];
-    
-    int32 MeshCount = TopPartMeshes.Num();
-    if (MeshCount < ExpectedCount)
-    {
-    }
+    TopPartInstancedMeshes.Reset();
+    TopParts.Reset();
+    TopPartHomeTransforms.Reset();
+    CubieTopParts.Init(INDEX_NONE, CubeState.GetNumCubies());
     
     if (bAutoAdjustTopPart)
     {
@@ -429,76 +1502,147 @@ void AMagicCubeActor::InitializeTopParts()
         }
     }
     
+    // 同一网格的部件放进同一个实例化组件；部件挂在创建时位于该槽位的方块上
+    TMap<UStaticMesh*, int32> MeshGroups;
+    TArray<int32> GroupUsedInstances;
+    TArray<bool> GroupDirty;
     int32 TopZ = Dimensions[2] - 1;
     for (int32 y = 0; y < Dimensions[1]; y++)
     {
         for (int32 x = 0; x < Dimensions[0]; x++)
         {
             int32 Index = x + y * Dimensions[0];
+            const int32 Cubie = CubeState.IsValid() ? CubeState.GetCubieAtSlot(GetLinearIndex(x, y, TopZ)) : MagicCube::InvalidIndex;
+            if (Index >= TopPartMeshes.Num() || !TopPartMeshes[Index] || Cubie == MagicCube::InvalidIndex)
+            {
+                continue;
+            }
+
+            int32* GroupPtr = MeshGroups.Find(TopPartMeshes[Index]);
+            if (!GroupPtr)
+            {
+                UInstancedStaticMeshComponent* GroupComp = nullptr;
+                if (!ExistingGroups.RemoveAndCopyValue(TopPartMeshes[Index], GroupComp))
+                {
+                    FString CompName = FString::Printf(TEXT("TopParts_%d"), TopPartInstancedMeshes.Num());
+                    GroupComp = NewObject<UInstancedStaticMeshComponent>(this, MakeUniqueObjectName(this, UInstancedStaticMeshComponent::StaticClass(), FName(*CompName)));
+                    GroupComp->SetStaticMesh(TopPartMeshes[Index]);
+                    GroupComp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+                    GroupComp->SetupAttachment(RootComponent);
+                    GroupComp->RegisterComponent();
+                }
+                GroupPtr = &MeshGroups.Add(TopPartMeshes[Index], TopPartInstancedMeshes.Add(GroupComp));
+                GroupUsedInstances.Add(0);
+                GroupDirty.Add(false);
+            }
+
             FVector BlockPos = CalculatePosition(x, y, TopZ);
             FVector PartPos = BlockPos + FVector(0, 0, TopPartVerticalOffset);
-            if (Index < TopPartMeshes.Num() && TopPartMeshes[Index])
+            const FTransform PartTransform(FQuat::Identity, PartPos, TopPartScale);
+
+            FTopPart& Part = TopParts.AddDefaulted_GetRef();
+            Part.Cubie = Cubie;
+            Part.Group = *GroupPtr;
+            Part.Instance = GroupUsedInstances[Part.Group]++;
+            UInstancedStaticMeshComponent* GroupComp = TopPartInstancedMeshes[Part.Group];
+            if (Part.Instance < GroupComp->GetInstanceCount())
             {
-                FString CompName = FString::Printf(TEXT("TopPart_%d"), Index);
-                UStaticMeshComponent* PartComp = NewObject<UStaticMeshComponent>(this, FName(*CompName));
-                if (PartComp)
+                FTransform Current;
+                GroupComp->GetInstanceTransform(Part.Instance, Current, /*bWorldSpace=*/ false);
+                if (!Current.Equals(PartTransform, KINDA_SMALL_NUMBER))
                 {
-                    PartComp->RegisterComponent();
-                    PartComp->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepRelativeTransform);
-                    PartComp->SetRelativeLocation(PartPos);
-                    PartComp->SetRelativeScale3D(TopPartScale);
-                    PartComp->SetStaticMesh(TopPartMeshes[Index]);
-                    TopPartComponents.Add(PartComp);
-                    TopPartInitialTransforms.Add(PartComp->GetRelativeTransform());
-                    PartComp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-                    // PartComp->SetCollisionResponseToAllChannels(ECR_Ignore);
+                    GroupComp->UpdateInstanceTransform(Part.Instance, PartTransform, /*bWorldSpace=*/ false, /*bMarkRenderStateDirty=*/ false, /*bTeleport=*/ true);
+                    GroupDirty[Part.Group] = true;
                 }
             }
+            else
+            {
+                GroupComp->AddInstance(PartTransform, /*bWorldSpace=*/ false);
+            }
+            CubieTopParts[Cubie] = TopParts.Num() - 1;
+            TopPartHomeTransforms.Add(PartTransform);
+        }
+    }
+
+    // 每组多出的实例从末尾删掉，用不上的组件销毁
+    for (int32 Group = 0; Group < TopPartInstancedMeshes.Num(); Group++)
+    {
+        UInstancedStaticMeshComponent* GroupComp = TopPartInstancedMeshes[Group];
+        TArray<int32> RemovedInstances;
+        for (int32 Instance = GroupComp->GetInstanceCount() - 1; Instance >= GroupUsedInstances[Group]; Instance--)
+        {
+            RemovedInstances.Add(Instance);
+        }
+        if (RemovedInstances.Num() > 0)
+        {
+            GroupComp->RemoveInstances(RemovedInstances, /*bInstanceArrayAlreadySortedInReverseOrder=*/ true);
+        }
+        if (GroupDirty[Group])
+        {
+            GroupComp->MarkRenderStateDirty();
         }
     }
+    for (const TPair<UStaticMesh*, UInstancedStaticMeshComponent*>& Pair : ExistingGroups)
+    {
+        Pair.Value->DestroyComponent();
+    }
 }
 
 void AMagicCubeActor::BeginLayerRotation(ECubeAxis Axis, int32 Layer)
 {
+    // 动画提交时按拖拽快照落位，中途换层会让正在转的层停在半路、和离散状态对不上
+    if (IsRotationAnimating())
+    {
+        return;
+    }
+    CancelSolveForPlayerMove();
+    StartLayerRotation(Axis, Layer);
+}
+
+void AMagicCubeActor::StartLayerRotation(ECubeAxis Axis, int32 Layer)
+{
+    SuspendInstanceCollision();
     bIsDraggingRotation = true;
     CurrentDragAxis = Axis;
     CurrentDragLayer = Layer;
+    CurrentDragAngle = 0.0f;
     
-    CollectLayerInstances(Axis, Layer, CurrentDragAffectedInstances);
+    CurrentDragCubies = CollectLayerInstances(Axis, Layer);
+    CurrentDragPivot = GetLayerPivot(Axis, Layer);
     
-    CurrentDragBaseTransforms.Empty();
-    for (int32 Index : CurrentDragAffectedInstances)
+    // 上一次提交时实例已吸附到离散状态，基准变换直接由状态算出，不读实例
+    CurrentDragBaseTransforms.Reset(CurrentDragCubies.Num());
+    for (int32 Index : CurrentDragCubies)
+    {
+        CurrentDragBaseTransforms.Add(GetCubieTransform(Index));
+    }
+    BuildLayerBatchRuns();
+    if (IsShaderLayerRotationActive())
     {
-        FTransform T;
-        InstancedMesh->GetInstanceTransform(Index, T, true);
-        CurrentDragBaseTransforms.Add(T);
+        SetLayerRotationMaterialLayer(true);
     }
     
-    // 对顶面部件：判断顶层对应的实例索引范围
-    int32 TopLayerStartIndex = Dimensions[0] * Dimensions[1] * (Dimensions[2]-1);
-    CurrentDragTopPartBaseTransforms.Empty();
-    if (TopPartComponents.Num() > 0)
+    // 只取转动层里方块上的部件，按方块编号直接查；和方块一样由离散状态算出，不读实例
+    CurrentDragTopPartBaseTransforms.Reset(CurrentDragCubies.Num());
+    for (int32 Index : CurrentDragCubies)
     {
-        for (int32 i = 0; i < TopPartComponents.Num(); i++)
-        {
-            if (TopPartComponents[i])
-            {
-                // 保存相对变换
-                CurrentDragTopPartBaseTransforms.Add(TopPartComponents[i]->GetRelativeTransform());
-            }
-            else
-            {
-                CurrentDragTopPartBaseTransforms.Add(FTransform::Identity);
-            }
-        }
+        const int32 PartIndex = CubieTopParts.IsValidIndex(Index) ? CubieTopParts[Index] : INDEX_NONE;
+        CurrentDragTopPartBaseTransforms.Add(PartIndex != INDEX_NONE ? GetTopPartTransform(PartIndex) : FTransform::Identity);
     }
 }
 
 void AMagicCubeActor::EndLayerRotationDrag()
 {
+    // 提交时最终变换和槽位坐标已经写好，同一帧关掉材质里的转动
+    if (IsShaderLayerRotationActive())
+    {
+        SetLayerRotationMaterialLayer(false);
+    }
     bIsDraggingRotation = false;
-    CurrentDragAffectedInstances.Empty();
+    CurrentDragCubies = TArrayView<const int32>();
     CurrentDragBaseTransforms.Empty();
+    CurrentDragBatchRuns.Empty();
+    CurrentDragBatchSlots.Empty();
     CurrentDragTopPartBaseTransforms.Empty();
 }
 
@@ -506,166 +1650,79 @@ void AMagicCubeActor::EndLayerRotationDrag()
 TArray<EMagicCubeFace> AMagicCubeActor::GetCubeFacesForBlock(int32 x, int32 y, int32 z) const
 {
     TArray<EMagicCubeFace> Faces;
-    // Teng：这里AI容易错，UE是左手坐标系，X是食指红色（对准屏幕），Y是中指绿色（对准屏幕右方），Z是大拇指蓝色（对准屏幕上方）
-    if (x == 0) Faces.Add(EMagicCubeFace::Front); // 前面
-    if (x == Dimensions[0] - 1) Faces.Add(EMagicCubeFace::Back); // 后面
-    if (x != 0 && x != Dimensions[0] - 1) Faces.Add(EMagicCubeFace::Standing); // 非前非后面
-    if (y == 0) Faces.Add(EMagicCubeFace::Left); // 左面
-    if (y == Dimensions[1] - 1) Faces.Add(EMagicCubeFace::Right); // 右面
-    if (y != 0 && y != Dimensions[1] - 1) Faces.Add(EMagicCubeFace::Middle); // 非左非右面
-    if (z == 0) Faces.Add(EMagicCubeFace::Bottom); // 底部
-    if (z == Dimensions[2] - 1) Faces.Add(EMagicCubeFace::Top); // 顶部
-    if (z != 0 && z != Dimensions[2] - 1) Faces.Add(EMagicCubeFace::Equatorial); // 非顶非底面
-
+    const FMagicCubeFaceMask Mask = GetCubeFaceMaskForBlock(x, y, z);
+    for (int32 FaceIndex = 0; FaceIndex < NumMagicCubeFaces; FaceIndex++)
+    {
+        if (Mask & MagicCubeFaceBit(static_cast<EMagicCubeFace>(FaceIndex)))
+        {
+            Faces.Add(static_cast<EMagicCubeFace>(FaceIndex));
+        }
+    }
     return Faces;
 }
 
-// 获取面的法向量
-FVector AMagicCubeActor::GetFaceNormal(EMagicCubeFace Face) const
+FMagicCubeFaceMask AMagicCubeActor::GetCubeFaceMaskForBlock(int32 x, int32 y, int32 z) const
 {
-    // 调用示例：
-    // 获取顶面的法向量
-    // FVector TopNormal = GetFaceNormal(EMagicCubeFace::Top);
-    // UE_LOG(LogTemp, Warning, TEXT("Top Face Normal: %s"), *TopNormal.ToString());
-    // // 获取左面的法向量
-    // FVector LeftNormal = GetFaceNormal(EMagicCubeFace::Left);
-    // UE_LOG(LogTemp, Warning, TEXT("Left Face Normal: %s"), *LeftNormal.ToString());
-
-    // 定义面与法向量的映射
     // Teng：这里AI容易错，UE是左手坐标系，X是食指红色（对准屏幕），Y是中指绿色（对准屏幕右方），Z是大拇指蓝色（对准屏幕上方）
-    TMap<EMagicCubeFace, FVector> FaceNormals = {
-        {EMagicCubeFace::Top, FVector(0, 0, 1)},
-        {EMagicCubeFace::Bottom, FVector(0, 0, -1)},
-        {EMagicCubeFace::Equatorial, FVector(0, 0, 1)},
-        {EMagicCubeFace::Front, FVector(-1, 0, 0)},
-        {EMagicCubeFace::Back, FVector(1, 0, 0)},
-        {EMagicCubeFace::Standing, FVector(-1, 0, 0)},
-        {EMagicCubeFace::Left, FVector(0, -1, 0)},
-        {EMagicCubeFace::Right, FVector(0, 1, 0)},
-        {EMagicCubeFace::Middle, FVector(0, -1, 0)}
-    };
+    FMagicCubeFaceMask Mask = 0;
+    if (x == 0) Mask |= MagicCubeFaceBit(EMagicCubeFace::Front); // 前面
+    if (x == Dimensions[0] - 1) Mask |= MagicCubeFaceBit(EMagicCubeFace::Back); // 后面
+    if (x != 0 && x != Dimensions[0] - 1) Mask |= MagicCubeFaceBit(EMagicCubeFace::Standing); // 非前非后面
+    if (y == 0) Mask |= MagicCubeFaceBit(EMagicCubeFace::Left); // 左面
+    if (y == Dimensions[1] - 1) Mask |= MagicCubeFaceBit(EMagicCubeFace::Right); // 右面
+    if (y != 0 && y != Dimensions[1] - 1) Mask |= MagicCubeFaceBit(EMagicCubeFace::Middle); // 非左非右面
+    if (z == 0) Mask |= MagicCubeFaceBit(EMagicCubeFace::Bottom); // 底部
+    if (z == Dimensions[2] - 1) Mask |= MagicCubeFaceBit(EMagicCubeFace::Top); // 顶部
+    if (z != 0 && z != Dimensions[2] - 1) Mask |= MagicCubeFaceBit(EMagicCubeFace::Equatorial); // 非顶非底面
+    return Mask;
+}
 
-    // 查找对应面的法向量，如果找不到则返回零向量
-    if (FaceNormals.Contains(Face))
-    {
-        return FaceNormals[Face];
-    }
-    else
+// 获取面的法向量，未定义的面返回零向量
+FVector AMagicCubeActor::GetFaceNormal(EMagicCubeFace Face) const
+{
+    const int32 FaceIndex = static_cast<int32>(Face);
+    if (FaceIndex >= NumMagicCubeFaces)
     {
-        return FVector::ZeroVector; // 返回零向量表示错误
+        return FVector::ZeroVector;
     }
+    const int8* Normal = MagicCubeFaceTopology[FaceIndex].Normal;
+    return FVector(Normal[0], Normal[1], Normal[2]);
 }
 
-// 获取面"顺时针"旋转的向量
+// 获取面"顺时针"旋转的向量，未定义的面返回零向量
 FVector AMagicCubeActor::GetFaceRotateDirection(EMagicCubeFace Face) const
 {
-    // 调用示例：
-    // 获取顶面的顺时针旋转向量
-    // FVector TopRotationAxis = GetFaceRotateDirection(EMagicCubeFace::Top);
-    // UE_LOG(LogTemp, Warning, TEXT("Top Face Rotation Axis: %s"), *TopRotationAxis.ToString());
-    // 获取左面的顺时针旋转向量
-    // FVector LeftRotationAxis = GetFaceRotateDirection(EMagicCubeFace::Left);
-    // UE_LOG(LogTemp, Warning, TEXT("Left Face Rotation Axis: %s"), *LeftRotationAxis.ToString());
-    
-    // 定义面与顺时针旋转向量的映射
-    // Teng：这里AI容易错，UE是左手坐标系，X是食指红色（对准屏幕），Y是中指绿色（对准屏幕右方），Z是大拇指蓝色（对准屏幕上方）
-    TMap<EMagicCubeFace, FVector> ClockRotateNormals = {
-        {EMagicCubeFace::Top, FVector(0, 1, 0)},
-        {EMagicCubeFace::Bottom, FVector(0, -1, 0)},
-        {EMagicCubeFace::Equatorial, FVector(0, 1, 0)},
-        {EMagicCubeFace::Front, FVector(0, 0, -1)},
-        {EMagicCubeFace::Back, FVector(0, 0, 1)},
-        {EMagicCubeFace::Standing, FVector(0, 0, -1)},
-        {EMagicCubeFace::Left, FVector(1, 0, 0)},
-        {EMagicCubeFace::Right, FVector(-1, 0, 0)},
-        {EMagicCubeFace::Middle, FVector(1, 0, 0)}
-    };
-
-    // 查找对应面的顺时针旋转轴向量，如果找不到则返回零向量
-    if (ClockRotateNormals.Contains(Face))
+    const int32 FaceIndex = static_cast<int32>(Face);
+    if (FaceIndex >= NumMagicCubeFaces)
     {
-        return ClockRotateNormals[Face];
-    }
-    else
-    {
-        return FVector::ZeroVector; // 返回零向量表示错误
+        return FVector::ZeroVector;
     }
+    const int8* Direction = MagicCubeFaceTopology[FaceIndex].RotateDirection;
+    return FVector(Direction[0], Direction[1], Direction[2]);
 }
-// 获取面的反面
+
+// 获取面的反面，中间层返回原面
 EMagicCubeFace AMagicCubeActor::GetOppositeFace(EMagicCubeFace Face) const
 {
-    // 定义面与反面的映射
-    // Teng：这里AI容易错，UE是左手坐标系，X是食指红色（对准屏幕），Y是中指绿色（对准屏幕右方），Z是大拇指蓝色（对准屏幕上方）
-    TMap<EMagicCubeFace, EMagicCubeFace> FaceAnti = {
-        {EMagicCubeFace::Top, EMagicCubeFace::Bottom},
-        {EMagicCubeFace::Bottom, EMagicCubeFace::Top},
-        {EMagicCubeFace::Front, EMagicCubeFace::Back},
-        {EMagicCubeFace::Back, EMagicCubeFace::Front},
-        {EMagicCubeFace::Left, EMagicCubeFace::Right},
-        {EMagicCubeFace::Right, EMagicCubeFace::Left}
-    };
-
-    // 查找对应面的反面，如果找不到则返回原面
-    if (FaceAnti.Contains(Face))
-    {
-        return FaceAnti[Face];
-    }
-    else
-    {
-        return Face; // 返回原面表示错误
-    }
+    const int32 FaceIndex = static_cast<int32>(Face);
+    return FaceIndex < NumMagicCubeFaces ? MagicCubeFaceTopology[FaceIndex].Opposite : Face;
 }
 
-// 获取面的旋转轴
+// 获取面的旋转轴，未定义的面返回X轴
 ECubeAxis AMagicCubeActor::GetRotateAxis(EMagicCubeFace Face) const
 {
-    // 定义面与旋转轴的映射
-    TMap<EMagicCubeFace, ECubeAxis> FaceRotateAxis = {
-        {EMagicCubeFace::Top, ECubeAxis::Z},
-        {EMagicCubeFace::Bottom, ECubeAxis::Z},
-        {EMagicCubeFace::Equatorial, ECubeAxis::Z},
-        {EMagicCubeFace::Front, ECubeAxis::X},
-        {EMagicCubeFace::Back, ECubeAxis::X},
-        {EMagicCubeFace::Standing, ECubeAxis::X},
-        {EMagicCubeFace::Left, ECubeAxis::Y},
-        {EMagicCubeFace::Right, ECubeAxis::Y},
-        {EMagicCubeFace::Middle, ECubeAxis::Y}
-    };
-
-    // 查找对应面的旋转轴，如果找不到则返回X轴
-    if (FaceRotateAxis.Contains(Face))
-    {
-        return FaceRotateAxis[Face];
-    }
-    else
-    {
-        return ECubeAxis::X; // 返回X轴表示错误或未定义
-    }
+    const int32 FaceIndex = static_cast<int32>(Face);
+    return FaceIndex < NumMagicCubeFaces ? MagicCubeFaceTopology[FaceIndex].Axis : ECubeAxis::X;
 }
 
-// 获取面的层索引
+// 获取面的层索引，未定义的面返回-1
 int32 AMagicCubeActor::GetLayerIndex(EMagicCubeFace Face) const
 {
-    // 定义面与层索引的映射
-    TMap<EMagicCubeFace, int32> FaceLayerIndex = {
-        {EMagicCubeFace::Top, Dimensions[2] - 1},
-        {EMagicCubeFace::Bottom, 0},
-        {EMagicCubeFace::Equatorial, Dimensions[2] - 2},
-        {EMagicCubeFace::Front, 0},
-        {EMagicCubeFace::Back, Dimensions[0] - 1},
-        {EMagicCubeFace::Standing, Dimensions[0] - 2},
-        {EMagicCubeFace::Left, 0},
-        {EMagicCubeFace::Right, Dimensions[1] - 1},
-        {EMagicCubeFace::Middle, Dimensions[1] - 2}
-    };
-
-    // 查找对应面的层索引，如果找不到则返回-1
-    if (FaceLayerIndex.Contains(Face))
-    {
-        return FaceLayerIndex[Face];
-    }
-    else
+    const int32 FaceIndex = static_cast<int32>(Face);
+    if (FaceIndex >= NumMagicCubeFaces)
     {
-        return -1; // 返回-1表示错误或未定义
+        return -1;
     }
+    const FMagicCubeFaceTopology& Topology = MagicCubeFaceTopology[FaceIndex];
+    return Topology.bLayerFromEnd ? Dimensions[GetDimensionIndex(Topology.Axis)] - Topology.LayerOffset : Topology.LayerOffset;
 }
\ No newline at end of file
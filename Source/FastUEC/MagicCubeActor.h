@@ -3,6 +3,8 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "Components/InstancedStaticMeshComponent.h"
+#include "MagicCubeCore.h"
+#include "MagicCubeFacelets.h"
 #include "MagicCubeActor.generated.h" // 确保正确保留
 
 // Teng：定义魔方的面类型，ECubeFace会编译失败，可能UE已经用了
@@ -29,7 +31,63 @@ enum class ECubeAxis : uint8
     Z
 };
 
+// 面拓扑：按 EMagicCubeFace 的值索引的编译期常量表，面、轴、层的查询直接查表，不分配也不哈希
+struct FMagicCubeFaceTopology
+{
+    ECubeAxis Axis;          // 旋转轴
+    int8 Normal[3];          // 法向量
+    int8 RotateDirection[3]; // "顺时针"旋转向量
+    EMagicCubeFace Opposite; // 反面，三个中间层没有反面，记为自身
+    bool bLayerFromEnd;      // 层索引 = bLayerFromEnd ? 该轴尺寸 - LayerOffset : LayerOffset
+    int8 LayerOffset;
+};
+
+inline constexpr int32 NumMagicCubeFaces = 9;
+
+// Teng：这里AI容易错，UE是左手坐标系，X是食指红色（对准屏幕），Y是中指绿色（对准屏幕右方），Z是大拇指蓝色（对准屏幕上方）
+inline constexpr FMagicCubeFaceTopology MagicCubeFaceTopology[NumMagicCubeFaces] = {
+    { ECubeAxis::Z, { 0, 0, 1 },  { 0, 1, 0 },  EMagicCubeFace::Bottom,     true,  1 }, // Top
+    { ECubeAxis::Z, { 0, 0, -1 }, { 0, -1, 0 }, EMagicCubeFace::Top,        false, 0 }, // Bottom
+    { ECubeAxis::X, { -1, 0, 0 }, { 0, 0, -1 }, EMagicCubeFace::Back,       false, 0 }, // Front
+    { ECubeAxis::X, { 1, 0, 0 },  { 0, 0, 1 },  EMagicCubeFace::Front,      true,  1 }, // Back
+    { ECubeAxis::Y, { 0, -1, 0 }, { 1, 0, 0 },  EMagicCubeFace::Right,      false, 0 }, // Left
+    { ECubeAxis::Y, { 0, 1, 0 },  { -1, 0, 0 }, EMagicCubeFace::Left,       true,  1 }, // Right
+    { ECubeAxis::Z, { 0, 0, 1 },  { 0, 1, 0 },  EMagicCubeFace::Equatorial, true,  2 }, // Equatorial
+    { ECubeAxis::Y, { 0, -1, 0 }, { 1, 0, 0 },  EMagicCubeFace::Middle,     true,  2 }, // Middle
+    { ECubeAxis::X, { -1, 0, 0 }, { 0, 0, -1 }, EMagicCubeFace::Standing,   true,  2 }, // Standing
+};
+
+// 面集合的位掩码：第 Face 位表示包含该面
+using FMagicCubeFaceMask = uint16;
+
+constexpr FMagicCubeFaceMask MagicCubeFaceBit(EMagicCubeFace Face)
+{
+    return static_cast<FMagicCubeFaceMask>(1u << static_cast<uint8>(Face));
+}
+
+// 一步层转动：QuarterTurns 为 90° 的倍数，正方向与 RotateLayer 的正角度一致
+USTRUCT(BlueprintType)
+struct FMagicCubeMove
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MagicCube")
+    ECubeAxis Axis = ECubeAxis::X;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MagicCube")
+    int32 Layer = 0;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MagicCube")
+    int32 QuarterTurns = 1;
+};
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnRotationComplete, ECubeAxis, Axis, int32, LayerIndex);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnCubeSolved);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnSolutionReady, bool, bSuccess, const TArray<FMagicCubeMove>&, Moves);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnSolveProgress, int64, NodesSearched, int32, Depth);
+
+struct FMagicCubeSolveJob;
+class UMaterialInstanceDynamic;
 
 UCLASS()
 class FASTUEC_API AMagicCubeActor : public AActor
@@ -43,6 +101,9 @@ public:
     UFUNCTION(BlueprintPure, Category = "MagicCube") // 标记为纯函数，可以在蓝图中安全使用
     TArray<EMagicCubeFace> GetCubeFacesForBlock(int32 x, int32 y, int32 z) const;
 
+    // 同上，返回位掩码，不分配
+    FMagicCubeFaceMask GetCubeFaceMaskForBlock(int32 x, int32 y, int32 z) const;
+
     // 获取面的法向量
     UFUNCTION(BlueprintPure, Category = "MagicCube")
     FVector GetFaceNormal(EMagicCubeFace Face) const; // 声明为const，表明不修改对象状态
@@ -63,15 +124,21 @@ public:
     UFUNCTION(BlueprintPure, Category = "MagicCube")
     int32 GetLayerIndex(EMagicCubeFace Face) const;
 
+    // 玩家开始拖拽，会取消正在进行的后台求解；正在播放转动动画时不开始
     UFUNCTION(BlueprintCallable, Category = "MagicCube")
     void BeginLayerRotation(ECubeAxis Axis, int32 Layer);
 
+    // 正在播放转动动画（包括松手后的回弹），此时拖拽会被拒绝
+    UFUNCTION(BlueprintPure, Category = "MagicCube")
+    bool IsRotationAnimating() const { return FMath::Abs(CurrentRotation.RemainingDegrees) > KINDA_SMALL_NUMBER; }
+
     UFUNCTION(BlueprintCallable, Category = "MagicCube")
     void EndLayerRotationDrag();
 
 protected:
     virtual void BeginPlay() override;
     virtual void Tick(float DeltaTime) override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
     virtual void OnConstruction(const FTransform& Transform) override;
 
 public:
@@ -96,9 +163,15 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MagicCube|TopParts")
     bool bAutoAdjustTopPart = true;
 
+    // 正在播放转动动画时忽略：动画结束前拖拽快照属于正在转的层，不能被换掉
     UFUNCTION(BlueprintCallable, Category = "MagicCube")
     void SetLayerRotation(ECubeAxis Axis, int32 Layer, float Angle);
 
+    // 查初始化离散状态时建好的合法性表：非正方形的层只能转 180° 的倍数
+    // 转动（动画、队列、立即提交）落位时会吸附到最近的合法角度，单步 90° 在这种层上变成 180°
+    UFUNCTION(BlueprintPure, Category = "MagicCube")
+    bool IsLayerTurnLegal(ECubeAxis Axis, int32 Layer, int32 QuarterTurns) const;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MagicCube")
     float RotationSpeed = 360.0f;
 
@@ -108,28 +181,138 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MagicCube")
     UMaterialInterface* CubeMaterial;
 
+    // 为 true 时 CubeMaterial 用到网格的所有材质槽，整个魔方只有一种材质，贴纸颜色由材质读实例自定义数据得到
+    // 自定义数据布局：[0] 方块的初始槽位下标（改布局掩码后方块编号会变，槽位不变）；[1 + d] 方块局部方向 d（+X,-X,+Y,-Y,+Z,-Z）上的贴纸颜色，即还原时所在面的编号，没有贴纸为 -1；
+    // [7..9] 槽位的 x/y/z 坐标：开启 bShaderLayerRotation 时是方块当前所在槽位，转动提交时更新
+    // 只在有材质读时分配：开启 bShaderLayerRotation 时 10 个，只开本选项时前 7 个，都不开时没有自定义数据
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MagicCube")
+    bool bStickerColorsFromCustomData = false;
+
+    // 为 true 时层转动的动画交给材质做：转动期间不写实例变换，每帧只设一个角度参数，提交时才写最终变换
+    // 网格各材质槽的材质需要实现对应的世界位置偏移（法线同样旋转）：自定义数据 [7 + LayerRotationAxisIndex] 等于 LayerRotationLayer 的实例，
+    // 绕经过 LayerRotationPivot、方向为 LayerRotationAxis 的轴（都在世界空间）按 FQuat 的方向转 LayerRotationAngle 度；LayerRotationLayer 为 -1 时没有层在转
+    // 顶面部件是单独的网格，仍由 CPU 更新
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MagicCube")
+    bool bShaderLayerRotation = false;
+
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "MagicCube")
     UInstancedStaticMeshComponent* InstancedMesh;
 
+    // 为 true 时只给表面方块创建实例；内部方块转动时永远不会到表面，只在离散状态里存在
+    // 布局掩码有空槽时内部方块可能露出来，此时不剔除
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MagicCube")
+    bool bCullInteriorCubies = true;
+
+    // 方块实例是否带碰撞体；拾取走 TraceBlock 的解析求交，不需要碰撞，关掉后转动时也不用同步物理体
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MagicCube")
+    bool bEnableInstanceCollision = true;
+
+    // 为 true 时层转动（拖拽或动画）期间暂停方块实例的碰撞，每帧改变换不再同步物理体；
+    // 空闲下来后一次性按当前变换重建碰撞。期间 TraceBlock 退化为和整个魔方的包围盒求交
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MagicCube")
+    bool bSuspendCollisionWhileTurning = false;
+
+    // 解析拾取：世界空间射线变换到组件局部空间，在网格上做 3D-DDA，命中第一个有方块的格子
+    // 有层正在转动时方块不在格子上，只和整个魔方的包围盒求交，取入口处的格子
+    // 输出块坐标、命中面的局部法向量（与 GetFaceNormal 同一空间）和沿射线的世界距离；不走物理查询
+    UFUNCTION(BlueprintCallable, Category = "MagicCube")
+    bool TraceBlock(const FVector& RayOrigin, const FVector& RayDirection, FIntVector& OutBlock, FVector& OutLocalNormal, float& OutDistance) const;
+
     UPROPERTY(BlueprintAssignable, Category = "MagicCube")
     FOnRotationComplete OnRotationComplete;
 
+    // 提交的转动让魔方从未还原变为还原时触发（整体转了方向也算还原）
+    UPROPERTY(BlueprintAssignable, Category = "MagicCube")
+    FOnCubeSolved OnCubeSolved;
+
+    // 缓存值，只在转动提交时更新，每帧查询没有开销
+    UFUNCTION(BlueprintPure, Category = "MagicCube")
+    bool IsSolved() const { return bIsSolved; }
+
+    // RotateLayer、QueueMove(s)、Scramble、ApplyMovesInstant、ResetCube 都视为玩家操作，会取消正在进行的后台求解
     UFUNCTION(BlueprintCallable, Category = "MagicCube")
     void RotateLayer(ECubeAxis Axis, int32 LayerIndex, float Degrees);
 
     UFUNCTION(BlueprintCallable, Category = "MagicCube")
     void Scramble(int32 Moves = 20);
 
+    // 把一步转动放入队列，由 Tick 依次执行；同层相邻（含中间只隔着同轴其他层）的转动会先合并或抵消
+    UFUNCTION(BlueprintCallable, Category = "MagicCube")
+    void QueueMove(ECubeAxis Axis, int32 Layer, int32 QuarterTurns);
+
+    UFUNCTION(BlueprintCallable, Category = "MagicCube")
+    void ClearPendingMoves();
+
+    // 依次放入队列，效果同逐个调用 QueueMove
+    UFUNCTION(BlueprintCallable, Category = "MagicCube")
+    void QueueMoves(const TArray<FMagicCubeMove>& Moves);
+
+    // 2x2x2 的最优解（以已提交的状态为准，不含正在播放和排队中的转动），已还原或尺寸不支持时返回空数组
+    // 查找表首次使用时生成并缓存到磁盘；结果交给 QueueMoves 即可逐步播放
+    UFUNCTION(BlueprintCallable, Category = "MagicCube")
+    TArray<FMagicCubeMove> Solve() const;
+
+    // 在后台求解当前已提交的状态（2x2x2 最优解，3x3x3 两阶段解），不阻塞游戏线程，结果由 Tick 取回后通过 OnSolutionReady 广播
+    // 3x3x3 找到不超过 TargetLength 步的解即返回；同一时间只有一个求解，新的求解会取消旧的
+    // 求解期间只要有转动提交（包括队列里的转动播放完），结果就已过期，会被自动丢弃且不广播
+    UFUNCTION(BlueprintCallable, Category = "MagicCube")
+    void SolveAsync(int32 TargetLength = 21);
+
+    UPROPERTY(BlueprintAssignable, Category = "MagicCube")
+    FOnSolutionReady OnSolutionReady;
+
+    // 求解期间每帧最多一次，数值有变化时广播：累计搜索节点数与当前深度（降阶法为当前步骤 1..4）
+    UPROPERTY(BlueprintAssignable, Category = "MagicCube")
+    FOnSolveProgress OnSolveProgress;
+
+    // 4 阶及以上（没有空槽的 N x N x N）：后台用降阶法求解，每找到一步就放进转动队列，整个解算完之前动画就开始播放
+    // 以已提交的状态为准：正在播放的转动先落位，排队中的转动被清空；拖拽中无法开始，返回 false
+    // 解算完成后广播一次 OnSolutionReady，Moves 为空（步骤已经进了队列）
+    UFUNCTION(BlueprintCallable, Category = "MagicCube")
+    bool StartStreamingSolve();
+
+    // 停止后台求解，不广播结果；流式求解已经进入转动队列的步骤照常播放（玩家自己转动时才一起丢掉）
+    UFUNCTION(BlueprintCallable, Category = "MagicCube")
+    void CancelSolve();
+
+    UFUNCTION(BlueprintPure, Category = "MagicCube")
+    bool IsSolving() const { return SolveJob.IsValid(); }
+
+    // 不播放动画，直接把一串转动提交到离散状态，每个方块的最终变换只算一次、整体一次批量提交
+    // 用于测试地图、回放和服务器校验；不会逐步广播 OnRotationComplete，返回实际执行的步数
+    UFUNCTION(BlueprintCallable, Category = "MagicCube")
+    int32 ApplyMovesInstant(const TArray<FMagicCubeMove>& Moves);
+
+    UFUNCTION(BlueprintPure, Category = "MagicCube")
+    int32 GetPendingMoveCount() const { return PendingMoves.Num() - PendingMoveHead; }
+
+    // 离散状态（只读），供求解、校验等 C++ 逻辑使用
+    const MagicCube::FCubeState& GetCubeState() const { return CubeState; }
+    // 贴纸级状态，只在 N x N x N 时有效
+    const MagicCube::FFaceletCube& GetFacelets() const { return Facelets; }
+
+    // 为 true 时队列里的转动不播放动画，直接提交到离散状态并一次性重建所有变换
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MagicCube")
+    bool bInstantMoves = false;
+
+    // 回到还原状态，丢弃正在播放和排队中的转动；实例下标不变，所有变换一次批量覆盖
     UFUNCTION(BlueprintCallable, Category = "MagicCube")
     void ResetCube();
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MagicCube|TopParts")
     TArray<UStaticMesh*> TopPartMeshes;
 
+    // 顶面部件按网格分组，每种网格一个实例化组件，一种网格一次绘制
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "MagicCube|TopParts")
-    TArray<UStaticMeshComponent*> TopPartComponents;
+    TArray<UInstancedStaticMeshComponent*> TopPartInstancedMeshes;
+
+    // 材质驱动转动时各材质槽用的动态材质实例，同一个父材质只建一个
+    UPROPERTY(Transient)
+    TArray<UMaterialInstanceDynamic*> LayerRotationMaterials;
 
     int32 GetDimensionIndex(ECubeAxis Axis) const;
+    // 槽位上现在有没有方块：运行时以离散状态为准（空槽会随转动移动），状态未建好时看布局掩码
+    bool IsSlotOccupied(int32 x, int32 y, int32 z) const;
     int32 GetLinearIndex(int32 x, int32 y, int32 z) const;
 
 private:
@@ -137,23 +320,131 @@ private:
         ECubeAxis Axis;
         int32 Layer;
         float RemainingDegrees;
-        TArray<int32> AffectedInstances;
+        float TargetAngle;  // 相对基准快照的最终角度
+        int32 QuarterTurns; // 本次旋转（含拖拽部分）最终提交到离散状态的 90° 次数
+        TArrayView<const int32> AffectedCubies;
     };
 
-    FRotationData CurrentRotation;
-    TArray<FTransform> InitialTransforms;
-    TArray<FTransform> TopPartInitialTransforms;
+    // 离散魔方状态，层成员查询与提交都走这里，不再扫描实例变换
+    MagicCube::FCubeState CubeState;
+
+    // N x N x N 时并行维护的贴纸级状态，转动提交时与 CubeState 一起更新
+    MagicCube::FFaceletCube Facelets;
+
+    // 正在进行的后台求解，工作线程写入、Tick 取出
+    TSharedPtr<FMagicCubeSolveJob, ESPMode::ThreadSafe> SolveJob;
+    // 已提交到离散状态的转动计数，求解快照记下当时的值，用来判断结果是否过期
+    int32 CommittedMoveCount = 0;
+    TSharedPtr<FMagicCubeSolveJob, ESPMode::ThreadSafe> StartSolveJob(bool bStreaming);
+    void UpdateSolveJob();
+    // 玩家操作打断求解：流式求解排进队列、还没播放的步骤也一起丢掉，玩家的操作不用排在它们后面
+    void CancelSolveForPlayerMove();
+
+    bool bIsSolved = true;
+    // 根据离散状态刷新 bIsSolved，返回是否刚刚变为还原
+    bool UpdateSolvedState();
 
-    TArray<int32> CurrentDragAffectedInstances;
+    FRotationData CurrentRotation;
+    // 顶面部件：所在的分组组件、组件内的实例下标，以及驮着它的方块
+    struct FTopPart {
+        int32 Cubie = INDEX_NONE;
+        int32 Group = INDEX_NONE;
+        int32 Instance = INDEX_NONE;
+    };
+    TArray<FTopPart> TopParts;
+    TArray<int32> CubieTopParts; // 方块编号 -> 部件下标，没有部件为 INDEX_NONE
+    TArray<TArray<FTransform>> TopPartGroupTransforms; // RefreshAllTransforms 的缓冲，每组一份
+    TArray<FTransform> TopPartHomeTransforms; // 创建时的相对变换，用于从离散状态直接重建部件位置
+
+    // 待执行的转动队列，PendingMoveHead 之前的已经出队
+    TArray<FMagicCubeMove> PendingMoves;
+    int32 PendingMoveHead = 0;
+    bool bPendingMovesStreamed = false; // 队列里是流式求解送来的步骤；求解期间其他入队路径都会先取消求解，不会混进别的转动
+    TArray<FTransform> RefreshTransforms; // RefreshAllTransforms 的缓冲
+    TArray<MagicCube::FLayerTurn> InstantTurns; // ApplyMovesInstant 的缓冲
+
+    TArrayView<const int32> CurrentDragCubies; // 转动层里有实例的方块
+    TArray<int32> CurrentDragVisibleCubies;    // 剔除内部方块时 CurrentDragCubies 的存储
+
+    // 方块与实例的对应：内部方块没有实例（INDEX_NONE），实例顺序见 InstanceHomeSlots
+    TArray<int32> CubieInstances;
+    TArray<int32> InstanceCubies;
+    void BuildCubieInstances();
+    bool IsHomeSlotVisible(int32 Slot, bool bCull) const;
+
+    // 每个实例上方块的初始槽位，和实例一起保存：改布局掩码时只增删变了的槽位，实例不再按槽位顺序排列，运行时靠它和已有实例对上
+    UPROPERTY()
+    TArray<int32> InstanceHomeSlots;
+
+    // 上次建实例时的布局和参数：只有布局掩码或剔除开关变了、离散状态在还原位置时才增量更新
+    TArray<bool> BuiltLayoutMask;
+    FIntVector BuiltDimensions = FIntVector::ZeroValue;
+    float BuiltBlockSize = 0.0f;
+    float BuiltBlockScale = 0.0f;
+    bool bBuiltCullInteriorCubies = false;
+    int32 HomeStateMoveCount = INDEX_NONE; // 离散状态最近一次处于还原位置时的 CommittedMoveCount
+    bool UpdateCubeLayout();
     TArray<FTransform> CurrentDragBaseTransforms;
-    TArray<FTransform> CurrentDragTopPartBaseTransforms;
+
+    // 整层变换的批量提交：受影响实例按下标合并成连续区段，每段一个缓冲
+    struct FInstanceBatchRun {
+        int32 StartIndex = 0;
+        TArray<FTransform> Transforms;
+    };
+    TArray<FInstanceBatchRun> CurrentDragBatchRuns;
+    TArray<FIntPoint> CurrentDragBatchSlots; // 与 CurrentDragCubies 对齐：(区段, 区段内偏移)
+    TArray<FTransform> CurrentDragTopPartBaseTransforms; // 与 CurrentDragCubies 对齐，没有部件的方块为单位变换
     ECubeAxis CurrentDragAxis;
     int32 CurrentDragLayer;
+    float CurrentDragAngle = 0.0f;
+    FVector CurrentDragPivot = FVector::ZeroVector;
+    float BlockScale = 1.0f;
     bool bIsDraggingRotation = false;
+    bool bCollisionSuspended = false;
+    bool IsLayerTurning() const { return bIsDraggingRotation || FMath::Abs(CurrentRotation.RemainingDegrees) > KINDA_SMALL_NUMBER; }
+    void SuspendInstanceCollision();
+    void RestoreInstanceCollision();
+
+    // 每层允许的转动：第 t 位表示转 t 个 90°（t = 0..3）合法；第 Axis 轴第 Layer 层在 LayerTurnOffsets[Axis] + Layer
+    TArray<uint8> LayerTurnMasks;
+    int32 LayerTurnOffsets[3] = {};
+    void BuildLayerTurnTable();
+    uint8 GetLayerTurnMask(ECubeAxis Axis, int32 Layer) const;
+    // 把目标角度吸附到最近的合法 90° 倍数；两边一样近时取真正转动的一边（不取转整圈），与角度正负无关
+    // 没有合法转动时返回 0。离散转动先用 NormalizeSignedQuarterTurns 归一再吸附
+    int32 SnapToLegalQuarterTurns(ECubeAxis Axis, int32 Layer, float Angle) const;
+
+    // 下面几个是对应公开接口去掉“取消求解”之后的部分，队列播放和流式求解内部使用
+    void StartLayerRotation(ECubeAxis Axis, int32 Layer);
+    void PlayLayerRotation(ECubeAxis Axis, int32 LayerIndex, float Degrees);
+    void EnqueueMove(ECubeAxis Axis, int32 Layer, int32 QuarterTurns);
+    int32 CommitMovesInstant(const TArray<FMagicCubeMove>& Moves);
 
     void InitializeCube();
+    void WriteCubieCustomData();
+    // 只写一个实例的前 NumFloats 个自定义数据，和已有数据相同时跳过，返回是否写了
+    bool WriteInstanceCustomData(int32 Instance, int32 NumFloats);
+    // 只重写这些方块的槽位坐标（自定义数据 [7..9]）
+    void WriteCubieSlotCustomData(TArrayView<const int32> Cubies);
+    void InitializeLayerRotationMaterials();
+    bool IsShaderLayerRotationActive() const { return bShaderLayerRotation && LayerRotationMaterials.Num() > 0; }
+    // bActive 为 false 时把层参数置为 -1，材质不再转动任何实例
+    void SetLayerRotationMaterialLayer(bool bActive);
     void InitializeTopParts();
+    void InitializeCubeState();
+    void FinishLayerRotation();
+    void ProcessPendingMoves();
+    void RefreshAllTransforms();
+    FTransform GetTopPartTransform(int32 PartIndex) const;
     FVector CalculatePosition(int32 x, int32 y, int32 z) const;
-    void CollectLayerInstances(ECubeAxis Axis, int32 Layer, TArray<int32>& OutInstances);
-    void ApplyRotationToInstances(float DeltaDegrees);
+    float ComputeBlockScale() const;
+    FTransform GetCubieTransform(int32 Cubie) const;
+    FVector GetLayerPivot(ECubeAxis Axis, int32 Layer) const;
+    FQuat GetLayerRotationQuat(ECubeAxis Axis, float Angle) const;
+    TArrayView<const int32> CollectLayerInstances(ECubeAxis Axis, int32 Layer);
+    void ApplyRotationToInstances(float Angle);
+    void BuildLayerBatchRuns();
+    void FlushLayerBatchRuns();
+    // bCommitted 为 true 时直接按离散状态落位，忽略 RotQuat
+    void UpdateTopPartsForLayerRotation(const FQuat& RotQuat, bool bCommitted = false);
 };
\ No newline at end of file
@@ -0,0 +1,192 @@
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "RenderingThread.h"
+#include "MagicCubeActor.h"
+#include "MagicCubeCore.h"
+#include "MagicCubeFacelets.h"
+#include "MagicCubeSolverTables.h"
+#include "MagicCubeSolverTasks.h"
+
+// Teng：控制台命令 MagicCube.BenchmarkFacelets [最大阶数=50] [每个阶数的步数=20000]
+// 对比逐方块的 FCubeState 和贴纸级 FFaceletCube 在 N = 3..最大阶数 上的每秒转动次数
+static void RunFaceletBenchmark(const TArray<FString>& Args)
+{
+    const int32 MaxOrder = Args.Num() > 0 ? FMath::Max(3, FCString::Atoi(*Args[0])) : 50;
+    const int32 NumMoves = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 20000;
+
+    FRandomStream Random(12345);
+    TArray<MagicCube::FLayerTurn> Moves;
+    for (int32 Order = 3; Order <= MaxOrder; Order++)
+    {
+        Moves.Reset(NumMoves);
+        for (int32 i = 0; i < NumMoves; i++)
+        {
+            Moves.Add(MagicCube::FLayerTurn{ Random.RandRange(0, 2), Random.RandRange(0, Order - 1), Random.RandRange(1, 3) });
+        }
+
+        MagicCube::FCubeState CubieState;
+        CubieState.Initialize(MagicCube::FCoords{ Order, Order, Order }, nullptr, 0);
+        const double CubieStart = FPlatformTime::Seconds();
+        for (const MagicCube::FLayerTurn& Move : Moves)
+        {
+            CubieState.ApplyMove(Move.AxisIndex, Move.Layer, Move.QuarterTurns);
+        }
+        const double CubieSeconds = FPlatformTime::Seconds() - CubieStart;
+
+        MagicCube::FFaceletCube Facelets;
+        Facelets.Initialize(Order);
+        const double FaceletStart = FPlatformTime::Seconds();
+        Facelets.ApplyMoves(Moves.GetData(), Moves.Num());
+        const double FaceletSeconds = FPlatformTime::Seconds() - FaceletStart;
+
+        UE_LOG(LogTemp, Display, TEXT("N=%d  cubie: %.0f moves/s  facelet: %.0f moves/s  (x%.1f)"),
+            Order,
+            NumMoves / FMath::Max(CubieSeconds, 1e-9),
+            NumMoves / FMath::Max(FaceletSeconds, 1e-9),
+            CubieSeconds / FMath::Max(FaceletSeconds, 1e-9));
+    }
+}
+
+static FAutoConsoleCommand GMagicCubeBenchmarkFaceletsCommand(
+    TEXT("MagicCube.BenchmarkFacelets"),
+    TEXT("Compare per-cubie and facelet move throughput for N = 3..Max. Usage: MagicCube.BenchmarkFacelets [Max=50] [Moves=20000]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunFaceletBenchmark));
+
+// Teng：控制台命令 MagicCube.BenchmarkTwoPhase [状态数=10000] [目标步数=21]
+// 用随机打乱（含中层转动）生成 3 阶状态，统计并行两阶段求解的平均/最大延迟和平均步数；查找表的加载时间单独统计
+static void RunTwoPhaseBenchmark(const TArray<FString>& Args)
+{
+    const int32 NumStates = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10000;
+    const int32 TargetLength = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 21;
+
+    const double LoadStart = FPlatformTime::Seconds();
+    FMagicCubeSolverTables::GetTwoPhaseSolver();
+    UE_LOG(LogTemp, Display, TEXT("Two-phase tables ready in %.1f ms"), (FPlatformTime::Seconds() - LoadStart) * 1000.0);
+
+    FRandomStream Random(12345);
+    std::vector<MagicCube::FLayerTurn> Solution;
+    double TotalSeconds = 0.0;
+    double MaxSeconds = 0.0;
+    int64 TotalLength = 0;
+    int32 NumFailed = 0;
+    for (int32 i = 0; i < NumStates; i++)
+    {
+        MagicCube::FCubeState State;
+        State.Initialize(MagicCube::FCoords{ 3, 3, 3 }, nullptr, 0);
+        for (int32 Move = 0; Move < 40; Move++)
+        {
+            State.ApplyMove(Random.RandRange(0, 2), Random.RandRange(0, 2), Random.RandRange(1, 3));
+        }
+
+        const double Start = FPlatformTime::Seconds();
+        const bool bSolved = FMagicCubeSolverTasks::SolveTwoPhase(State, TargetLength, Solution);
+        const double Seconds = FPlatformTime::Seconds() - Start;
+        TotalSeconds += Seconds;
+        MaxSeconds = FMath::Max(MaxSeconds, Seconds);
+
+        State.ApplyMoves(Solution.data(), static_cast<int32>(Solution.size()));
+        NumFailed += (bSolved && State.IsSolved()) ? 0 : 1;
+        TotalLength += static_cast<int64>(Solution.size());
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("Two-phase: %d states  avg %.3f ms  max %.3f ms  avg length %.2f  failed %d"),
+        NumStates,
+        TotalSeconds * 1000.0 / NumStates,
+        MaxSeconds * 1000.0,
+        static_cast<double>(TotalLength) / NumStates,
+        NumFailed);
+}
+
+static FAutoConsoleCommand GMagicCubeBenchmarkTwoPhaseCommand(
+    TEXT("MagicCube.BenchmarkTwoPhase"),
+    TEXT("Average latency of the parallel two-phase 3x3x3 solver over random states. Usage: MagicCube.BenchmarkTwoPhase [States=10000] [TargetLength=21]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunTwoPhaseBenchmark));
+
+// Teng：控制台命令 MagicCube.BenchmarkLayerUpdate [最大阶数=20] [帧数=120]
+// 在当前世界里临时生成 N = 3..最大阶数 的魔方，拖着第 0 层转动，对比两种每帧的实例更新方式：
+//   逐个：每个实例一次 UpdateInstanceTransform，每次都标记渲染状态（批量提交之前的做法）
+//   批量：SetLayerRotation，即区段缓冲 + BatchUpdateInstancesTransforms，渲染状态每帧标记一次
+// 每帧之后执行 SendAllEndOfFrameUpdates，最后等渲染线程处理完，计时包含渲染状态重建；需要在开发版或发布版（非 Debug）里跑才有意义
+static void RunLayerUpdateBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+    const int32 MaxOrder = Args.Num() > 0 ? FMath::Max(3, FCString::Atoi(*Args[0])) : 20;
+    const int32 NumFrames = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 120;
+    UStaticMesh* Mesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+    if (!World || !Mesh)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("MagicCube.BenchmarkLayerUpdate needs a world and /Engine/BasicShapes/Cube"));
+        return;
+    }
+
+    for (int32 Order = 3; Order <= MaxOrder; Order++)
+    {
+        AMagicCubeActor* Cube = World->SpawnActorDeferred<AMagicCubeActor>(AMagicCubeActor::StaticClass(), FTransform::Identity);
+        Cube->Dimensions = { Order, Order, Order };
+        Cube->CubeMesh = Mesh;
+        Cube->FinishSpawning(FTransform::Identity);
+        UInstancedStaticMeshComponent* Instances = Cube->InstancedMesh;
+
+        // 逐个更新的对照组：第 0 层（X 最小）的实例和它们的基准变换
+        const float LayerX = -(Order - 1) * 0.5f * Cube->BlockSize;
+        TArray<int32> LayerInstances;
+        TArray<FTransform> BaseTransforms;
+        for (int32 Instance = 0; Instance < Instances->GetInstanceCount(); Instance++)
+        {
+            FTransform Transform;
+            Instances->GetInstanceTransform(Instance, Transform, /*bWorldSpace=*/ false);
+            if (FMath::IsNearlyEqual(Transform.GetLocation().X, LayerX, 1.0f))
+            {
+                LayerInstances.Add(Instance);
+                BaseTransforms.Add(Transform);
+            }
+        }
+
+        FlushRenderingCommands();
+        const double PerInstanceStart = FPlatformTime::Seconds();
+        for (int32 Frame = 0; Frame < NumFrames; Frame++)
+        {
+            const FQuat RotQuat(FVector::ForwardVector, FMath::DegreesToRadians(Frame * 0.5f));
+            for (int32 i = 0; i < LayerInstances.Num(); i++)
+            {
+                const FTransform& Base = BaseTransforms[i];
+                const FTransform NewTransform(RotQuat * Base.GetRotation(), RotQuat.RotateVector(Base.GetLocation()), Base.GetScale3D());
+                Instances->UpdateInstanceTransform(LayerInstances[i], NewTransform, /*bWorldSpace=*/ false, /*bMarkRenderStateDirty=*/ true, /*bTeleport=*/ true);
+            }
+            World->SendAllEndOfFrameUpdates();
+        }
+        FlushRenderingCommands();
+        const double PerInstanceSeconds = FPlatformTime::Seconds() - PerInstanceStart;
+
+        // 复位后走批量路径
+        for (int32 i = 0; i < LayerInstances.Num(); i++)
+        {
+            Instances->UpdateInstanceTransform(LayerInstances[i], BaseTransforms[i], /*bWorldSpace=*/ false, /*bMarkRenderStateDirty=*/ false, /*bTeleport=*/ true);
+        }
+        World->SendAllEndOfFrameUpdates();
+        FlushRenderingCommands();
+        const double BatchedStart = FPlatformTime::Seconds();
+        for (int32 Frame = 0; Frame < NumFrames; Frame++)
+        {
+            Cube->SetLayerRotation(ECubeAxis::X, 0, Frame * 0.5f);
+            World->SendAllEndOfFrameUpdates();
+        }
+        FlushRenderingCommands();
+        const double BatchedSeconds = FPlatformTime::Seconds() - BatchedStart;
+        Cube->EndLayerRotationDrag();
+        Cube->Destroy();
+
+        UE_LOG(LogTemp, Display, TEXT("N=%d  layer %d instances  per-instance: %.3f ms/frame  batched: %.3f ms/frame  (x%.1f)"),
+            Order,
+            LayerInstances.Num(),
+            PerInstanceSeconds * 1000.0 / NumFrames,
+            BatchedSeconds * 1000.0 / NumFrames,
+            PerInstanceSeconds / FMath::Max(BatchedSeconds, 1e-9));
+    }
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GMagicCubeBenchmarkLayerUpdateCommand(
+    TEXT("MagicCube.BenchmarkLayerUpdate"),
+    TEXT("Per-frame cost of dragging one layer: per-instance updates vs the batched path, N = 3..Max. Usage: MagicCube.BenchmarkLayerUpdate [Max=20] [Frames=120]"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunLayerUpdateBenchmark));
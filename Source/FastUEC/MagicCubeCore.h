@@ -0,0 +1,1020 @@
+#pragma once
+
+// Teng：魔方的纯逻辑核心，只依赖标准库，不依赖 UObject/引擎，可以脱离 UE 单独编译、测试和做性能分析
+// AMagicCubeActor 只是它上面的一层适配：把离散状态换算成实例变换、把蓝图调用翻译成层转动
+//
+// 槽位(Slot) = 网格里的一个格子，线性下标 x + y * X + z * X * Y，与 AMagicCubeActor::GetLinearIndex 一致
+// 方块(Cubie) = 一个实体魔方块，Initialize 时编号按 LayoutMask 中有方块的槽位顺序分配；AddCubie/RemoveCubie 增量修改后不再保证这个顺序
+// 朝向(Orientation) = 24 种 90° 旋转组成的群的下标，0 为初始朝向
+// 轴下标 0/1/2 对应 X/Y/Z，正方向与 FQuat(轴, +角度) 一致
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace MagicCube
+{
+    static constexpr int32_t NumOrientations = 24;
+    static constexpr int32_t InvalidIndex = -1;
+
+    struct FCoords
+    {
+        int32_t X = 0;
+        int32_t Y = 0;
+        int32_t Z = 0;
+
+        int32_t& operator[](int32_t Index) { return Index == 0 ? X : (Index == 1 ? Y : Z); }
+        int32_t operator[](int32_t Index) const { return Index == 0 ? X : (Index == 1 ? Y : Z); }
+        bool operator==(const FCoords& Other) const { return X == Other.X && Y == Other.Y && Z == Other.Z; }
+        bool operator!=(const FCoords& Other) const { return !(*this == Other); }
+    };
+
+    // 一步层转动
+    struct FLayerTurn
+    {
+        int32_t AxisIndex = 0;
+        int32_t Layer = 0;
+        int32_t QuarterTurns = 0;
+    };
+
+    // 四元数分量，与 FQuat 的 (X, Y, Z, W) 一一对应
+    struct FQuatValue
+    {
+        double X = 0.0;
+        double Y = 0.0;
+        double Z = 0.0;
+        double W = 1.0;
+    };
+
+    // 只读的连续区间（指针 + 数量）
+    struct FIndexSpan
+    {
+        const int32_t* Data = nullptr;
+        int32_t Count = 0;
+
+        int32_t Num() const { return Count; }
+        int32_t operator[](int32_t Index) const { return Data[Index]; }
+        const int32_t* begin() const { return Data; }
+        const int32_t* end() const { return Data + Count; }
+    };
+
+    // 求解任务与调用方共享的控制块：调用方随时可以置位 bCancel；求解器累加搜索节点数、更新当前深度，供进度显示
+    struct FSearchControl
+    {
+        std::atomic<bool> bCancel{ false };
+        std::atomic<int64_t> Nodes{ 0 };
+        std::atomic<int32_t> Depth{ 0 };
+
+        bool IsCancelled() const { return bCancel.load(std::memory_order_relaxed); }
+        void AddNodes(int64_t Count) { Nodes.fetch_add(Count, std::memory_order_relaxed); }
+        void SetDepth(int32_t Value) { Depth.store(Value, std::memory_order_relaxed); }
+    };
+
+    constexpr int32_t NormalizeQuarterTurns(int32_t QuarterTurns)
+    {
+        return ((QuarterTurns % 4) + 4) % 4;
+    }
+
+    // 同一转动统一写成 -1..2（半圈记为 +2），写法不同的等价转动得到相同结果
+    constexpr int32_t NormalizeSignedQuarterTurns(int32_t QuarterTurns)
+    {
+        const int32_t Turns = NormalizeQuarterTurns(QuarterTurns);
+        return Turns == 3 ? -1 : Turns;
+    }
+
+    // 24 种 90° 旋转：整数矩阵（M * v）、对应四元数、乘法表
+    // 全部在编译期生成，运行时只是查表
+    struct FOrientationTable
+    {
+        int32_t Matrices[NumOrientations][3][3] = {};
+        FQuatValue Quats[NumOrientations] = {};
+        uint8_t Compose[NumOrientations][NumOrientations] = {};
+        uint8_t QuarterTurns[3][4] = {};
+        // 朝向 o 下当前朝向方向 d（轴 * 2 + (负向 ? 1 : 0)）的那一面，初始时朝向哪个方向，即那里贴纸的颜色
+        uint8_t HomeFaces[NumOrientations][6] = {};
+
+        constexpr FOrientationTable()
+        {
+            // 绕 X/Y/Z 轴 +90° 的生成元
+            // X: (y,z)->(-z,y)  Y: (z,x)->(-x,z)  Z: (x,y)->(-y,x)
+            int32_t Generators[3][3][3] = {};
+            FQuatValue GeneratorQuats[3] = {};
+            for (int32_t Axis = 0; Axis < 3; Axis++)
+            {
+                const int32_t U = (Axis + 1) % 3;
+                const int32_t V = (Axis + 2) % 3;
+                Generators[Axis][Axis][Axis] = 1;
+                Generators[Axis][U][V] = -1;
+                Generators[Axis][V][U] = 1;
+
+                const double HalfSqrt2 = 0.70710678118654752440;
+                GeneratorQuats[Axis] = FQuatValue{ Axis == 0 ? HalfSqrt2 : 0.0, Axis == 1 ? HalfSqrt2 : 0.0, Axis == 2 ? HalfSqrt2 : 0.0, HalfSqrt2 };
+            }
+
+            // 从单位旋转开始广度优先展开整个群
+            int32_t Count = 1;
+            for (int32_t i = 0; i < 3; i++)
+            {
+                Matrices[0][i][i] = 1;
+            }
+            Quats[0] = FQuatValue();
+            for (int32_t Index = 0; Index < Count; Index++)
+            {
+                for (int32_t Axis = 0; Axis < 3; Axis++)
+                {
+                    int32_t Product[3][3] = {};
+                    Multiply(Generators[Axis], Matrices[Index], Product);
+                    if (Find(Product, Count) == InvalidIndex)
+                    {
+                        Copy(Product, Matrices[Count]);
+                        Quats[Count] = Snap(Multiply(GeneratorQuats[Axis], Quats[Index]));
+                        Count++;
+                    }
+                }
+            }
+
+            for (int32_t A = 0; A < NumOrientations; A++)
+            {
+                for (int32_t B = 0; B < NumOrientations; B++)
+                {
+                    int32_t Product[3][3] = {};
+                    Multiply(Matrices[A], Matrices[B], Product);
+                    Compose[A][B] = static_cast<uint8_t>(Find(Product, NumOrientations));
+                }
+            }
+
+            for (int32_t Axis = 0; Axis < 3; Axis++)
+            {
+                const uint8_t Quarter = static_cast<uint8_t>(Find(Generators[Axis], NumOrientations));
+                QuarterTurns[Axis][0] = 0;
+                for (int32_t Turn = 1; Turn < 4; Turn++)
+                {
+                    QuarterTurns[Axis][Turn] = Compose[Quarter][QuarterTurns[Axis][Turn - 1]];
+                }
+            }
+
+            // 当前 = M * 初始，所以初始方向 = M^T * 当前方向
+            for (int32_t Orientation = 0; Orientation < NumOrientations; Orientation++)
+            {
+                for (int32_t Face = 0; Face < 6; Face++)
+                {
+                    const int32_t Axis = Face / 2;
+                    const int32_t Sign = (Face % 2 == 0) ? 1 : -1;
+                    for (int32_t HomeAxis = 0; HomeAxis < 3; HomeAxis++)
+                    {
+                        const int32_t Component = Sign * Matrices[Orientation][Axis][HomeAxis];
+                        if (Component != 0)
+                        {
+                            HomeFaces[Orientation][Face] = static_cast<uint8_t>(HomeAxis * 2 + (Component > 0 ? 0 : 1));
+                        }
+                    }
+                }
+            }
+        }
+
+        static constexpr void Multiply(const int32_t A[3][3], const int32_t B[3][3], int32_t Out[3][3])
+        {
+            for (int32_t Row = 0; Row < 3; Row++)
+            {
+                for (int32_t Col = 0; Col < 3; Col++)
+                {
+                    Out[Row][Col] = A[Row][0] * B[0][Col] + A[Row][1] * B[1][Col] + A[Row][2] * B[2][Col];
+                }
+            }
+        }
+
+        static constexpr void Copy(const int32_t From[3][3], int32_t To[3][3])
+        {
+            for (int32_t Row = 0; Row < 3; Row++)
+            {
+                for (int32_t Col = 0; Col < 3; Col++)
+                {
+                    To[Row][Col] = From[Row][Col];
+                }
+            }
+        }
+
+        // Hamilton 积，与 FQuat 的 A * B（先 B 后 A）一致
+        static constexpr FQuatValue Multiply(const FQuatValue& A, const FQuatValue& B)
+        {
+            return FQuatValue{
+                A.W * B.X + A.X * B.W + A.Y * B.Z - A.Z * B.Y,
+                A.W * B.Y - A.X * B.Z + A.Y * B.W + A.Z * B.X,
+                A.W * B.Z + A.X * B.Y - A.Y * B.X + A.Z * B.W,
+                A.W * B.W - A.X * B.X - A.Y * B.Y - A.Z * B.Z };
+        }
+
+        constexpr int32_t Find(const int32_t M[3][3], int32_t Count) const
+        {
+            for (int32_t Index = 0; Index < Count; Index++)
+            {
+                bool bEqual = true;
+                for (int32_t i = 0; i < 9; i++)
+                {
+                    bEqual = bEqual && Matrices[Index][i / 3][i % 3] == M[i / 3][i % 3];
+                }
+                if (bEqual)
+                {
+                    return Index;
+                }
+            }
+            return InvalidIndex;
+        }
+
+        // 90° 旋转的四元数分量只可能是 0、±1/2、±√2/2、±1，吸附掉连乘的浮点误差
+        static constexpr FQuatValue Snap(const FQuatValue& Q)
+        {
+            auto SnapComponent = [](double C)
+            {
+                const double Magnitude = C < 0.0 ? -C : C;
+                const double Candidates[] = { 0.0, 0.5, 0.70710678118654752440, 1.0 };
+                double Best = 0.0;
+                double BestError = Magnitude;
+                for (double Candidate : Candidates)
+                {
+                    const double Error = Magnitude > Candidate ? Magnitude - Candidate : Candidate - Magnitude;
+                    if (Error < BestError)
+                    {
+                        Best = Candidate;
+                        BestError = Error;
+                    }
+                }
+                return C < 0.0 ? -Best : Best;
+            };
+            return FQuatValue{ SnapComponent(Q.X), SnapComponent(Q.Y), SnapComponent(Q.Z), SnapComponent(Q.W) };
+        }
+    };
+
+    inline constexpr FOrientationTable OrientationTable;
+
+    inline const FOrientationTable& GetOrientationTable()
+    {
+        return OrientationTable;
+    }
+
+    inline const FQuatValue& GetOrientationQuat(uint8_t Orientation)
+    {
+        return GetOrientationTable().Quats[Orientation];
+    }
+
+    inline uint8_t ComposeOrientation(uint8_t Outer, uint8_t Inner)
+    {
+        return GetOrientationTable().Compose[Outer][Inner];
+    }
+
+    inline uint8_t GetQuarterTurnOrientation(int32_t AxisIndex, int32_t QuarterTurns)
+    {
+        return GetOrientationTable().QuarterTurns[AxisIndex][NormalizeQuarterTurns(QuarterTurns)];
+    }
+
+    // 固定阶数（N x N x N 且没有空槽）的状态内核，2 阶和 3 阶是最常用的尺寸
+    // 每个槽位一个格子 = 方块编号 << 5 | 朝向：2 阶 8 个 8 位格子正好一个 64 位字，3 阶 27 个 16 位格子
+    // 层转动的槽位置换在编译期生成，转动就是固定长度的收集 + 查表改朝向 + 散射，没有分支也不分配
+    template <int32_t N>
+    struct TFixedCubeKernel
+    {
+        static constexpr int32_t NumSlots = N * N * N;
+        static constexpr int32_t LayerSize = N * N;
+
+        using FCell = std::conditional_t<(NumSlots <= 8), uint8_t, uint16_t>;
+        using FCells = std::array<FCell, NumSlots>;
+
+        struct FMoveTables
+        {
+            // 每层的槽位，以及转 0~3 个 90° 后各自的去向
+            int16_t LayerSlots[3][N][LayerSize] = {};
+            int16_t TargetSlots[3][N][4][LayerSize] = {};
+            FCells HomeCells = {};
+
+            constexpr FMoveTables()
+            {
+                for (int32_t Slot = 0; Slot < NumSlots; Slot++)
+                {
+                    HomeCells[Slot] = static_cast<FCell>(Slot << 5);
+                }
+
+                for (int32_t AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+                {
+                    for (int32_t Layer = 0; Layer < N; Layer++)
+                    {
+                        int32_t Count = 0;
+                        for (int32_t Slot = 0; Slot < NumSlots; Slot++)
+                        {
+                            const int32_t Coords[3] = { Slot % N, (Slot / N) % N, Slot / LayerSize };
+                            if (Coords[AxisIndex] != Layer)
+                            {
+                                continue;
+                            }
+
+                            LayerSlots[AxisIndex][Layer][Count] = static_cast<int16_t>(Slot);
+                            for (int32_t Turns = 0; Turns < 4; Turns++)
+                            {
+                                // 与 FCubeState::RotateSlot 相同：以中心为原点的两倍坐标乘旋转矩阵
+                                const int32_t (&M)[3][3] = OrientationTable.Matrices[OrientationTable.QuarterTurns[AxisIndex][Turns]];
+                                int32_t Target[3] = {};
+                                for (int32_t i = 0; i < 3; i++)
+                                {
+                                    int32_t Rotated = N - 1;
+                                    for (int32_t j = 0; j < 3; j++)
+                                    {
+                                        Rotated += M[i][j] * (2 * Coords[j] - (N - 1));
+                                    }
+                                    Target[i] = Rotated / 2;
+                                }
+                                TargetSlots[AxisIndex][Layer][Turns][Count] = static_cast<int16_t>(Target[0] + Target[1] * N + Target[2] * LayerSize);
+                            }
+                            Count++;
+                        }
+                    }
+                }
+            }
+        };
+
+        static constexpr FMoveTables Tables = {};
+
+        // 还原状态：方块编号等于槽位，朝向为 0
+        static constexpr const FCells& GetHomeCells() { return Tables.HomeCells; }
+
+        // Turns 必须已归一化到 0~3；转 0 次也走同一条路径（恒等置换 + 恒等朝向）
+        static void ApplyMove(FCells& Cells, int32_t AxisIndex, int32_t Layer, int32_t Turns)
+        {
+            const int16_t* Sources = Tables.LayerSlots[AxisIndex][Layer];
+            const int16_t* Targets = Tables.TargetSlots[AxisIndex][Layer][Turns];
+            const uint8_t* Compose = OrientationTable.Compose[OrientationTable.QuarterTurns[AxisIndex][Turns]];
+
+            FCell Gathered[LayerSize];
+            for (int32_t i = 0; i < LayerSize; i++)
+            {
+                Gathered[i] = Cells[Sources[i]];
+            }
+            for (int32_t i = 0; i < LayerSize; i++)
+            {
+                Cells[Targets[i]] = static_cast<FCell>((Gathered[i] & ~31u) | Compose[Gathered[i] & 31u]);
+            }
+        }
+
+        static bool IsHome(const FCells& Cells) { return Cells == Tables.HomeCells; }
+    };
+
+    // 魔方的离散状态：槽位 <-> 方块排列 + 方块朝向，外加每个轴的层索引表
+    class FCubeState
+    {
+    public:
+        // 根据尺寸和布局掩码建立还原状态；Mask 为空或长度不足的部分视为有方块
+        void Initialize(const FCoords& InDimensions, const bool* LayoutMask, int32_t LayoutMaskNum)
+        {
+            Dimensions = InDimensions;
+            const int32_t TotalSlots = Dimensions.X * Dimensions.Y * Dimensions.Z;
+
+            CubieHomeSlot.clear();
+            for (int32_t AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+            {
+                LayerCycleOffsets[AxisIndex].clear();
+            }
+            for (int32_t Slot = 0; Slot < TotalSlots; Slot++)
+            {
+                const bool bPlaceBlock = (LayoutMask && Slot < LayoutMaskNum) ? LayoutMask[Slot] : true;
+                if (bPlaceBlock)
+                {
+                    CubieHomeSlot.push_back(Slot);
+                }
+            }
+
+            // 没有空槽的 2 阶、3 阶改走编译期特化的内核，其他尺寸走通用路径
+            const bool bFullCube = Dimensions.X == Dimensions.Y && Dimensions.Y == Dimensions.Z && static_cast<int32_t>(CubieHomeSlot.size()) == TotalSlots;
+            FixedOrder = (bFullCube && (Dimensions.X == 2 || Dimensions.X == 3)) ? Dimensions.X : 0;
+
+            BuildSolvedHashes();
+            Reset();
+        }
+
+        // 回到还原状态（不改变尺寸和掩码）
+        void Reset()
+        {
+            SlotToCubie.assign(Dimensions.X * Dimensions.Y * Dimensions.Z, InvalidIndex);
+            CubieToSlot = CubieHomeSlot;
+            CubieOrientation.assign(CubieHomeSlot.size(), 0);
+            for (int32_t Cubie = 0; Cubie < GetNumCubies(); Cubie++)
+            {
+                SlotToCubie[CubieHomeSlot[Cubie]] = Cubie;
+            }
+            RebuildLayerTables();
+            RecomputeStateHash();
+            FixedCells2 = TFixedCubeKernel<2>::GetHomeCells();
+            FixedCells3 = TFixedCubeKernel<3>::GetHomeCells();
+        }
+
+        bool IsValid() const { return !SlotToCubie.empty(); }
+        const FCoords& GetDimensions() const { return Dimensions; }
+        int32_t GetNumSlots() const { return static_cast<int32_t>(SlotToCubie.size()); }
+        int32_t GetNumCubies() const { return static_cast<int32_t>(CubieToSlot.size()); }
+
+        // 使用的固定阶数内核（2 或 3），0 表示通用路径
+        int32_t GetFixedOrder() const { return FixedOrder; }
+
+        // 可见贴纸的 Zobrist 哈希：每张外表面贴纸按 (槽位, 方向, 颜色) 取一个 64 位键异或起来
+        // 只看颜色不看方块编号，所以大阶魔方里外观相同的中心块互换不影响结果；每步转动只更新该层的方块
+        uint64_t GetStateHash() const { return StateHash; }
+
+        // 每个面颜色一致即为还原，整体转了任意 90° 倍数也算；与预先算好的至多 24 个还原哈希比较，O(1)
+        bool IsSolved() const
+        {
+            for (int32_t i = 0; i < NumSolvedHashes; i++)
+            {
+                if (StateHash == SolvedHashes[i])
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // 每个方块都在初始槽位且朝向为 0
+        bool IsAtHome() const
+        {
+            switch (FixedOrder)
+            {
+                case 2: return TFixedCubeKernel<2>::IsHome(FixedCells2);
+                case 3: return TFixedCubeKernel<3>::IsHome(FixedCells3);
+                default: break;
+            }
+            for (int32_t Cubie = 0; Cubie < GetNumCubies(); Cubie++)
+            {
+                if (CubieToSlot[Cubie] != CubieHomeSlot[Cubie] || CubieOrientation[Cubie] != 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        int32_t GetSlotIndex(int32_t X, int32_t Y, int32_t Z) const { return X + Y * Dimensions.X + Z * Dimensions.X * Dimensions.Y; }
+        int32_t GetSlotIndex(const FCoords& Coords) const { return GetSlotIndex(Coords.X, Coords.Y, Coords.Z); }
+        FCoords GetSlotCoords(int32_t Slot) const
+        {
+            const int32_t LayerSize = Dimensions.X * Dimensions.Y;
+            return FCoords{ Slot % Dimensions.X, (Slot % LayerSize) / Dimensions.X, Slot / LayerSize };
+        }
+
+        // 槽位上的方块，空槽返回 InvalidIndex
+        int32_t GetCubieAtSlot(int32_t Slot) const { return SlotToCubie[Slot]; }
+        int32_t GetCubieSlot(int32_t Cubie) const { return CubieToSlot[Cubie]; }
+        int32_t GetCubieHomeSlot(int32_t Cubie) const { return CubieHomeSlot[Cubie]; }
+        uint8_t GetCubieOrientation(int32_t Cubie) const { return CubieOrientation[Cubie]; }
+
+        // 某一层当前的方块，直接返回维护好的连续区间，不分配也不读变换
+        // 区间内顺序不固定；只在 Initialize/Reset/ApplyMoves/AddCubie/RemoveCubie 时整体失效
+        FIndexSpan GetLayerCubies(int32_t AxisIndex, int32_t Layer) const
+        {
+            if (!IsValid() || AxisIndex < 0 || AxisIndex > 2 || Layer < 0 || Layer >= Dimensions[AxisIndex])
+            {
+                return FIndexSpan();
+            }
+            return FIndexSpan{ LayerCubies[AxisIndex].data() + Layer * GetLayerCapacity(AxisIndex), LayerCounts[AxisIndex][Layer] };
+        }
+
+        // 把一层旋转 QuarterTurns 个 90°
+        // 旋转后有方块越界（非正方形层转 90°）时返回 false 且状态不变
+        bool ApplyMove(int32_t AxisIndex, int32_t Layer, int32_t QuarterTurns)
+        {
+            if (!IsValid() || AxisIndex < 0 || AxisIndex > 2 || Layer < 0 || Layer >= Dimensions[AxisIndex])
+            {
+                return false;
+            }
+
+            const int32_t Turns = NormalizeQuarterTurns(QuarterTurns);
+            if (Turns == 0)
+            {
+                return true;
+            }
+
+            const FOrientationTable& Table = GetOrientationTable();
+            const uint8_t MoveOrientation = Table.QuarterTurns[AxisIndex][Turns];
+
+            // 先算出所有目标槽位，任何一个越界就放弃整步，保证状态不被破坏
+            // 转动轴上的层成员不变，下面只改其他两个轴的层表，所以这里可以直接引用
+            const FIndexSpan MoveCubies = GetLayerCubies(AxisIndex, Layer);
+            MoveTargets.clear();
+            for (int32_t Cubie : MoveCubies)
+            {
+                const int32_t Target = RotateSlot(CubieToSlot[Cubie], MoveOrientation);
+                if (Target == InvalidIndex)
+                {
+                    return false;
+                }
+                MoveTargets.push_back(Target);
+            }
+
+            // 先全部移出再全部加入，否则满层会在中途暂时溢出
+            const int32_t U = (AxisIndex + 1) % 3;
+            const int32_t V = (AxisIndex + 2) % 3;
+            for (int32_t i = 0; i < MoveCubies.Num(); i++)
+            {
+                const int32_t Cubie = MoveCubies[i];
+                const FCoords From = GetSlotCoords(CubieToSlot[Cubie]);
+                const FCoords To = GetSlotCoords(MoveTargets[i]);
+                if (From[U] != To[U])
+                {
+                    RemoveFromLayer(U, From[U], Cubie);
+                }
+                if (From[V] != To[V])
+                {
+                    RemoveFromLayer(V, From[V], Cubie);
+                }
+                SlotToCubie[CubieToSlot[Cubie]] = InvalidIndex;
+                StateHash ^= GetCubieKey(CubieToSlot[Cubie], CubieOrientation[Cubie]);
+            }
+            for (int32_t i = 0; i < MoveCubies.Num(); i++)
+            {
+                const int32_t Cubie = MoveCubies[i];
+                const FCoords To = GetSlotCoords(MoveTargets[i]);
+                if (CubieLayerPosition[U][Cubie] == InvalidIndex)
+                {
+                    AddToLayer(U, To[U], Cubie);
+                }
+                if (CubieLayerPosition[V][Cubie] == InvalidIndex)
+                {
+                    AddToLayer(V, To[V], Cubie);
+                }
+                CubieToSlot[Cubie] = MoveTargets[i];
+                SlotToCubie[MoveTargets[i]] = Cubie;
+                CubieOrientation[Cubie] = Table.Compose[MoveOrientation][CubieOrientation[Cubie]];
+                StateHash ^= GetCubieKey(MoveTargets[i], CubieOrientation[Cubie]);
+            }
+
+            // 固定阶数内核与上面的数组保持同步
+            switch (FixedOrder)
+            {
+                case 2: TFixedCubeKernel<2>::ApplyMove(FixedCells2, AxisIndex, Layer, Turns); break;
+                case 3: TFixedCubeKernel<3>::ApplyMove(FixedCells3, AxisIndex, Layer, Turns); break;
+                default: break;
+            }
+            return true;
+        }
+
+        // 批量提交一串转动：期间改用槽位主序的紧凑格子数组，每步只按预计算的 4 元循环搬运，
+        // 结束后再一次性重建方块索引和层表。非法的转动（非正方形层转 90°）被跳过，返回实际执行的步数
+        int32_t ApplyMoves(const FLayerTurn* Moves, int32_t NumMoves)
+        {
+            if (!IsValid())
+            {
+                return 0;
+            }
+            switch (FixedOrder)
+            {
+                case 2: return ApplyMovesFixed<2>(FixedCells2, Moves, NumMoves);
+                case 3: return ApplyMovesFixed<3>(FixedCells3, Moves, NumMoves);
+                default: break;
+            }
+            if (static_cast<int32_t>(LayerCycleOffsets[0].size()) != Dimensions.X + 1)
+            {
+                BuildLayerCycles();
+            }
+
+            // 打包成槽位主序：高位为方块编号 + 1（0 表示空槽），低 5 位为朝向
+            // 空槽的低位也会被朝向表改写，但解包时高位为 0 仍然是空槽，所以搬运时不需要分支
+            const int32_t TotalSlots = GetNumSlots();
+            PackedCells.resize(TotalSlots);
+            uint32_t* Cells = PackedCells.data();
+            for (int32_t Slot = 0; Slot < TotalSlots; Slot++)
+            {
+                const int32_t Cubie = SlotToCubie[Slot];
+                Cells[Slot] = (Cubie == InvalidIndex) ? 0u : ((static_cast<uint32_t>(Cubie + 1) << 5) | CubieOrientation[Cubie]);
+            }
+
+            const FOrientationTable& Table = GetOrientationTable();
+            int32_t Applied = 0;
+            for (int32_t MoveIndex = 0; MoveIndex < NumMoves; MoveIndex++)
+            {
+                const FLayerTurn& Move = Moves[MoveIndex];
+                if (Move.AxisIndex < 0 || Move.AxisIndex > 2 || Move.Layer < 0 || Move.Layer >= Dimensions[Move.AxisIndex])
+                {
+                    continue;
+                }
+                const int32_t Turns = NormalizeQuarterTurns(Move.QuarterTurns);
+                const bool bSquare = LayerIsSquare[Move.AxisIndex] != 0;
+                if (!bSquare && (Turns & 1) != 0)
+                {
+                    continue;
+                }
+                Applied++;
+                if (Turns == 0)
+                {
+                    continue;
+                }
+
+                const uint8_t* Compose = Table.Compose[Table.QuarterTurns[Move.AxisIndex][Turns]];
+                const std::vector<int32_t>& Offsets = LayerCycleOffsets[Move.AxisIndex];
+                const int32_t* Cycle = LayerCycleSlots[Move.AxisIndex].data() + Offsets[Move.Layer];
+                const int32_t* CycleEnd = LayerCycleSlots[Move.AxisIndex].data() + Offsets[Move.Layer + 1];
+                if (bSquare)
+                {
+                    for (; Cycle < CycleEnd; Cycle += 4)
+                    {
+                        const uint32_t C0 = Cells[Cycle[0]];
+                        const uint32_t C1 = Cells[Cycle[1]];
+                        const uint32_t C2 = Cells[Cycle[2]];
+                        const uint32_t C3 = Cells[Cycle[3]];
+                        Cells[Cycle[Turns]] = (C0 & ~31u) | Compose[C0 & 31u];
+                        Cells[Cycle[(Turns + 1) & 3]] = (C1 & ~31u) | Compose[C1 & 31u];
+                        Cells[Cycle[(Turns + 2) & 3]] = (C2 & ~31u) | Compose[C2 & 31u];
+                        Cells[Cycle[(Turns + 3) & 3]] = (C3 & ~31u) | Compose[C3 & 31u];
+                    }
+                }
+                else
+                {
+                    for (; Cycle < CycleEnd; Cycle += 2)
+                    {
+                        const uint32_t C0 = Cells[Cycle[0]];
+                        const uint32_t C1 = Cells[Cycle[1]];
+                        Cells[Cycle[1]] = (C0 & ~31u) | Compose[C0 & 31u];
+                        Cells[Cycle[0]] = (C1 & ~31u) | Compose[C1 & 31u];
+                    }
+                }
+            }
+
+            // 解包并一次性重建层表
+            for (int32_t Slot = 0; Slot < TotalSlots; Slot++)
+            {
+                const uint32_t Cell = Cells[Slot];
+                const int32_t Cubie = static_cast<int32_t>(Cell >> 5) - 1;
+                SlotToCubie[Slot] = Cubie;
+                if (Cubie >= 0)
+                {
+                    CubieToSlot[Cubie] = Slot;
+                    CubieOrientation[Cubie] = static_cast<uint8_t>(Cell & 31u);
+                }
+            }
+            RebuildLayerTables();
+            RecomputeStateHash();
+            return Applied;
+        }
+
+        // 编辑布局掩码用：在空槽 Slot 上放一个初始朝向的新方块，初始槽位就是 Slot，只改这一个方块和还原哈希，不重建整个状态
+        // 新方块编号为原来的方块数。应在还原状态下调用，否则 Slot 可能是别的方块的初始槽位
+        // 放完会变成没有空槽的 2 阶、3 阶时，固定阶数内核要求编号等于槽位，返回 false 且状态不变，由调用方重新 Initialize
+        bool AddCubie(int32_t Slot)
+        {
+            if (!IsValid() || Slot < 0 || Slot >= GetNumSlots() || SlotToCubie[Slot] != InvalidIndex)
+            {
+                return false;
+            }
+            const bool bBecomesFull = GetNumCubies() + 1 == GetNumSlots();
+            if (bBecomesFull && Dimensions.X == Dimensions.Y && Dimensions.Y == Dimensions.Z && (Dimensions.X == 2 || Dimensions.X == 3))
+            {
+                return false;
+            }
+
+            const int32_t Cubie = GetNumCubies();
+            CubieHomeSlot.push_back(Slot);
+            CubieToSlot.push_back(Slot);
+            CubieOrientation.push_back(0);
+            SlotToCubie[Slot] = Cubie;
+            const FCoords Coords = GetSlotCoords(Slot);
+            for (int32_t AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+            {
+                CubieLayerPosition[AxisIndex].push_back(InvalidIndex);
+                AddToLayer(AxisIndex, Coords[AxisIndex], Cubie);
+            }
+            StateHash ^= GetCubieKey(Slot, 0);
+            UpdateRotationHashes(Slot, 1);
+            CollectSolvedHashes();
+            return true;
+        }
+
+        // 拿掉 Slot 上现在的方块，只改这一个方块和还原哈希。编号保持连续：原来编号最大的方块改用被拿掉的编号，
+        // OutMovedCubie 返回它的旧编号（被拿掉的就是最后一个时为 InvalidIndex），调用方按它同步以方块编号为下标的数据
+        // 之后固定阶数内核不再适用，改走通用路径
+        bool RemoveCubie(int32_t Slot, int32_t& OutMovedCubie)
+        {
+            OutMovedCubie = InvalidIndex;
+            if (!IsValid() || Slot < 0 || Slot >= GetNumSlots() || SlotToCubie[Slot] == InvalidIndex)
+            {
+                return false;
+            }
+
+            const int32_t Cubie = SlotToCubie[Slot];
+            StateHash ^= GetCubieKey(Slot, CubieOrientation[Cubie]);
+            UpdateRotationHashes(CubieHomeSlot[Cubie], -1);
+            const FCoords Coords = GetSlotCoords(Slot);
+            for (int32_t AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+            {
+                RemoveFromLayer(AxisIndex, Coords[AxisIndex], Cubie);
+            }
+            SlotToCubie[Slot] = InvalidIndex;
+
+            const int32_t LastCubie = GetNumCubies() - 1;
+            if (Cubie != LastCubie)
+            {
+                CubieHomeSlot[Cubie] = CubieHomeSlot[LastCubie];
+                CubieToSlot[Cubie] = CubieToSlot[LastCubie];
+                CubieOrientation[Cubie] = CubieOrientation[LastCubie];
+                SlotToCubie[CubieToSlot[Cubie]] = Cubie;
+                const FCoords LastCoords = GetSlotCoords(CubieToSlot[Cubie]);
+                for (int32_t AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+                {
+                    const int32_t Position = CubieLayerPosition[AxisIndex][LastCubie];
+                    CubieLayerPosition[AxisIndex][Cubie] = Position;
+                    LayerCubies[AxisIndex][LastCoords[AxisIndex] * GetLayerCapacity(AxisIndex) + Position] = Cubie;
+                }
+                OutMovedCubie = LastCubie;
+            }
+            CubieHomeSlot.pop_back();
+            CubieToSlot.pop_back();
+            CubieOrientation.pop_back();
+            for (int32_t AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+            {
+                CubieLayerPosition[AxisIndex].pop_back();
+            }
+
+            FixedOrder = 0;
+            CollectSolvedHashes();
+            return true;
+        }
+
+        // 槽位在某个 90° 旋转下的去向（绕魔方中心），越界返回 InvalidIndex
+        int32_t RotateSlot(int32_t Slot, uint8_t Rotation) const
+        {
+            const int32_t (&M)[3][3] = GetOrientationTable().Matrices[Rotation];
+
+            // 以魔方中心为原点的两倍坐标，避免偶数阶出现半格
+            const FCoords Coords = GetSlotCoords(Slot);
+            int32_t Doubled[3];
+            for (int32_t i = 0; i < 3; i++)
+            {
+                Doubled[i] = 2 * Coords[i] - (Dimensions[i] - 1);
+            }
+
+            FCoords Target;
+            for (int32_t i = 0; i < 3; i++)
+            {
+                const int32_t Rotated = M[i][0] * Doubled[0] + M[i][1] * Doubled[1] + M[i][2] * Doubled[2] + Dimensions[i] - 1;
+                if (Rotated < 0 || (Rotated & 1) != 0 || Rotated / 2 >= Dimensions[i])
+                {
+                    return InvalidIndex;
+                }
+                Target[i] = Rotated / 2;
+            }
+            return GetSlotIndex(Target);
+        }
+
+    private:
+        FCoords Dimensions;
+
+        std::vector<int32_t> SlotToCubie;
+        std::vector<int32_t> CubieToSlot;
+        std::vector<int32_t> CubieHomeSlot;
+        std::vector<uint8_t> CubieOrientation;
+
+        // 每个轴的层索引表：第 Layer 层占据 [Layer * 层容量, Layer * 层容量 + LayerCounts) 区间
+        // 层转动只会让方块在其他两个轴的层之间移动，提交时逐个交换删除/追加，O(层大小)
+        std::vector<int32_t> LayerCubies[3];
+        std::vector<int32_t> LayerCounts[3];
+        std::vector<int32_t> CubieLayerPosition[3];
+
+        // ApplyMove 的临时缓冲，避免每步分配
+        std::vector<int32_t> MoveTargets;
+
+        // ApplyMoves 用：每层在 90° 下的槽位循环（正方形层为 4 元组，否则为 180° 的 2 元组），首次批量提交时生成
+        std::vector<int32_t> LayerCycleSlots[3];
+        std::vector<int32_t> LayerCycleOffsets[3];
+        uint8_t LayerIsSquare[3] = {};
+        std::vector<uint32_t> PackedCells;
+
+        // 可见贴纸哈希，以及各种整体朝向下的还原哈希（只收录能放进当前尺寸的朝向）
+        uint64_t StateHash = 0;
+        uint64_t SolvedHashes[NumOrientations] = {};
+        int32_t NumSolvedHashes = 0;
+
+        // 每个整体朝向下还原状态的哈希，以及有几个方块转出了网格；增删一个方块只改各自的一项
+        uint64_t RotationHashes[NumOrientations] = {};
+        int32_t RotationMisfits[NumOrientations] = {};
+
+        // 槽位在外表面上的方向位掩码（bit d 对应方向 d），内部槽位为 0
+        uint8_t GetSlotFaceMask(int32_t Slot) const
+        {
+            const FCoords Coords = GetSlotCoords(Slot);
+            uint8_t Mask = 0;
+            for (int32_t AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+            {
+                Mask |= (Coords[AxisIndex] == Dimensions[AxisIndex] - 1) ? static_cast<uint8_t>(1u << (AxisIndex * 2)) : 0;
+                Mask |= (Coords[AxisIndex] == 0) ? static_cast<uint8_t>(1u << (AxisIndex * 2 + 1)) : 0;
+            }
+            return Mask;
+        }
+
+        // splitmix64：不需要随机数表，键按需算出
+        static uint64_t MixKey(uint64_t Value)
+        {
+            Value += 0x9E3779B97F4A7C15ull;
+            Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ull;
+            Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBull;
+            return Value ^ (Value >> 31);
+        }
+
+        // 某个朝向的方块放在某个槽位时，它露在外面的贴纸对哈希的贡献
+        uint64_t GetCubieKey(int32_t Slot, uint8_t Orientation) const
+        {
+            const uint8_t* HomeFaces = OrientationTable.HomeFaces[Orientation];
+            uint8_t Mask = GetSlotFaceMask(Slot);
+            uint64_t Key = 0;
+            for (int32_t Face = 0; Mask != 0; Face++, Mask >>= 1)
+            {
+                if (Mask & 1u)
+                {
+                    Key ^= MixKey(static_cast<uint64_t>((static_cast<int64_t>(Slot) * 6 + Face) * 6 + HomeFaces[Face]));
+                }
+            }
+            return Key;
+        }
+
+        void RecomputeStateHash()
+        {
+            StateHash = 0;
+            for (int32_t Cubie = 0; Cubie < GetNumCubies(); Cubie++)
+            {
+                StateHash ^= GetCubieKey(CubieToSlot[Cubie], CubieOrientation[Cubie]);
+            }
+        }
+
+        // 还原状态整体旋转 G 之后的哈希：方块 c 位于 G(初始槽位)、朝向为 G；G 转出网格（非立方体）则跳过
+        void BuildSolvedHashes()
+        {
+            for (int32_t Rotation = 0; Rotation < NumOrientations; Rotation++)
+            {
+                RotationHashes[Rotation] = 0;
+                RotationMisfits[Rotation] = 0;
+            }
+            for (int32_t HomeSlot : CubieHomeSlot)
+            {
+                UpdateRotationHashes(HomeSlot, 1);
+            }
+            CollectSolvedHashes();
+        }
+
+        // 把初始槽位为 HomeSlot 的方块计入（Delta = 1）或移出（Delta = -1）每个整体朝向的还原哈希，异或两次正好抵消
+        void UpdateRotationHashes(int32_t HomeSlot, int32_t Delta)
+        {
+            for (int32_t Rotation = 0; Rotation < NumOrientations; Rotation++)
+            {
+                const int32_t Slot = RotateSlot(HomeSlot, static_cast<uint8_t>(Rotation));
+                if (Slot == InvalidIndex)
+                {
+                    RotationMisfits[Rotation] += Delta;
+                }
+                else
+                {
+                    RotationHashes[Rotation] ^= GetCubieKey(Slot, static_cast<uint8_t>(Rotation));
+                }
+            }
+        }
+
+        // 没有方块转出网格的朝向才能算还原，哈希相同的只留一个
+        void CollectSolvedHashes()
+        {
+            NumSolvedHashes = 0;
+            for (int32_t Rotation = 0; Rotation < NumOrientations; Rotation++)
+            {
+                bool bDuplicate = false;
+                for (int32_t i = 0; i < NumSolvedHashes; i++)
+                {
+                    bDuplicate = bDuplicate || SolvedHashes[i] == RotationHashes[Rotation];
+                }
+                if (RotationMisfits[Rotation] == 0 && !bDuplicate)
+                {
+                    SolvedHashes[NumSolvedHashes++] = RotationHashes[Rotation];
+                }
+            }
+        }
+
+        // 固定阶数内核的格子，只有 FixedOrder 对应的那份有效
+        int32_t FixedOrder = 0;
+        TFixedCubeKernel<2>::FCells FixedCells2 = {};
+        TFixedCubeKernel<3>::FCells FixedCells3 = {};
+
+        template <int32_t N>
+        int32_t ApplyMovesFixed(typename TFixedCubeKernel<N>::FCells& Cells, const FLayerTurn* Moves, int32_t NumMoves)
+        {
+            // 固定阶数下每层都是正方形，所有转动都合法，只需检查范围
+            int32_t Applied = 0;
+            for (int32_t MoveIndex = 0; MoveIndex < NumMoves; MoveIndex++)
+            {
+                const FLayerTurn& Move = Moves[MoveIndex];
+                if (Move.AxisIndex < 0 || Move.AxisIndex > 2 || Move.Layer < 0 || Move.Layer >= N)
+                {
+                    continue;
+                }
+                TFixedCubeKernel<N>::ApplyMove(Cells, Move.AxisIndex, Move.Layer, NormalizeQuarterTurns(Move.QuarterTurns));
+                Applied++;
+            }
+
+            // 没有空槽，方块编号就是格子高位
+            for (int32_t Slot = 0; Slot < TFixedCubeKernel<N>::NumSlots; Slot++)
+            {
+                const int32_t Cubie = Cells[Slot] >> 5;
+                SlotToCubie[Slot] = Cubie;
+                CubieToSlot[Cubie] = Slot;
+                CubieOrientation[Cubie] = static_cast<uint8_t>(Cells[Slot] & 31u);
+            }
+            RebuildLayerTables();
+            RecomputeStateHash();
+            return Applied;
+        }
+
+        int32_t GetLayerCapacity(int32_t AxisIndex) const { return Dimensions[(AxisIndex + 1) % 3] * Dimensions[(AxisIndex + 2) % 3]; }
+
+        void AddToLayer(int32_t AxisIndex, int32_t Layer, int32_t Cubie)
+        {
+            const int32_t Position = LayerCounts[AxisIndex][Layer]++;
+            LayerCubies[AxisIndex][Layer * GetLayerCapacity(AxisIndex) + Position] = Cubie;
+            CubieLayerPosition[AxisIndex][Cubie] = Position;
+        }
+
+        void RemoveFromLayer(int32_t AxisIndex, int32_t Layer, int32_t Cubie)
+        {
+            const int32_t Base = Layer * GetLayerCapacity(AxisIndex);
+            const int32_t Position = CubieLayerPosition[AxisIndex][Cubie];
+            const int32_t LastPosition = --LayerCounts[AxisIndex][Layer];
+
+            // 用最后一个元素填补空位，保持区间连续
+            const int32_t LastCubie = LayerCubies[AxisIndex][Base + LastPosition];
+            LayerCubies[AxisIndex][Base + Position] = LastCubie;
+            CubieLayerPosition[AxisIndex][LastCubie] = Position;
+            LayerCubies[AxisIndex][Base + LastPosition] = InvalidIndex;
+            CubieLayerPosition[AxisIndex][Cubie] = InvalidIndex;
+        }
+
+        void RebuildLayerTables()
+        {
+            for (int32_t AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+            {
+                LayerCubies[AxisIndex].assign(SlotToCubie.size(), InvalidIndex);
+                LayerCounts[AxisIndex].assign(Dimensions[AxisIndex], 0);
+                CubieLayerPosition[AxisIndex].assign(CubieToSlot.size(), InvalidIndex);
+            }
+
+            for (int32_t Cubie = 0; Cubie < GetNumCubies(); Cubie++)
+            {
+                const FCoords Coords = GetSlotCoords(CubieToSlot[Cubie]);
+                for (int32_t AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+                {
+                    AddToLayer(AxisIndex, Coords[AxisIndex], Cubie);
+                }
+            }
+        }
+
+        void BuildLayerCycles()
+        {
+            const FOrientationTable& Table = GetOrientationTable();
+            std::vector<bool> Visited;
+            for (int32_t AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+            {
+                Visited.assign(SlotToCubie.size(), false);
+
+                const int32_t U = (AxisIndex + 1) % 3;
+                const int32_t V = (AxisIndex + 2) % 3;
+                const bool bSquare = Dimensions[U] == Dimensions[V];
+                const uint8_t Quarter = Table.QuarterTurns[AxisIndex][1];
+                const uint8_t Half = Table.QuarterTurns[AxisIndex][2];
+
+                std::vector<int32_t>& Cycles = LayerCycleSlots[AxisIndex];
+                std::vector<int32_t>& Offsets = LayerCycleOffsets[AxisIndex];
+                Cycles.clear();
+                Offsets.clear();
+                Offsets.push_back(0);
+                LayerIsSquare[AxisIndex] = bSquare ? 1 : 0;
+
+                FCoords Coords;
+                for (Coords[AxisIndex] = 0; Coords[AxisIndex] < Dimensions[AxisIndex]; Coords[AxisIndex]++)
+                {
+                    for (Coords[V] = 0; Coords[V] < Dimensions[V]; Coords[V]++)
+                    {
+                        for (Coords[U] = 0; Coords[U] < Dimensions[U]; Coords[U]++)
+                        {
+                            const int32_t Slot = GetSlotIndex(Coords);
+                            if (Visited[Slot])
+                            {
+                                continue;
+                            }
+
+                            // 正方形层按 90° 记录 4 元循环 s0->s1->s2->s3；否则只能转 180°，记录对换
+                            // 层中心是不动点，记成 (c,c,c,c) 这样的退化循环，搬运时朝向照样会更新
+                            const int32_t Length = bSquare ? 4 : 2;
+                            int32_t Cycle[4] = { Slot, Slot, Slot, Slot };
+                            for (int32_t i = 1; i < Length; i++)
+                            {
+                                Cycle[i] = RotateSlot(Cycle[i - 1], bSquare ? Quarter : Half);
+                                Visited[Cycle[i]] = true;
+                            }
+                            Visited[Slot] = true;
+                            Cycles.insert(Cycles.end(), Cycle, Cycle + Length);
+                        }
+                    }
+                    Offsets.push_back(static_cast<int32_t>(Cycles.size()));
+                }
+            }
+        }
+    };
+}
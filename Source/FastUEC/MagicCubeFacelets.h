@@ -0,0 +1,331 @@
+#pragma once
+
+// Teng：贴纸级（facelet）的魔方状态，给大阶数用：6 个面 × N² 张贴纸，每张一个字节记录颜色（即初始所在面）
+// 与 FCubeState 使用相同的轴/层/转向约定，转动接口也一致，可以并排维护
+// 面内的整行搬运、面旋转（转置 + 行反转）、180° 翻转都按 16 字节一组走 SSE2，其他平台走标量路径
+//
+// 面下标 = 轴 * 2 + (正向面 ? 0 : 1)
+// 法线轴为 A 的面，贴纸 (u, v) 对应方块坐标 [(A+1)%3] = u、[(A+2)%3] = v，下标 u + v * N
+
+#include "MagicCubeCore.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if !defined(MAGICCUBE_FACELETS_SSE2)
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define MAGICCUBE_FACELETS_SSE2 1
+    #else
+        #define MAGICCUBE_FACELETS_SSE2 0
+    #endif
+#endif
+
+#if MAGICCUBE_FACELETS_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace MagicCube
+{
+    namespace FaceletKernels
+    {
+#if MAGICCUBE_FACELETS_SSE2
+        // 16 字节倒序（只用 SSE2：先倒 32 位、再倒 16 位、最后交换字节）
+        inline __m128i Reverse16(__m128i Value)
+        {
+            Value = _mm_shuffle_epi32(Value, _MM_SHUFFLE(0, 1, 2, 3));
+            Value = _mm_shufflelo_epi16(Value, _MM_SHUFFLE(2, 3, 0, 1));
+            Value = _mm_shufflehi_epi16(Value, _MM_SHUFFLE(2, 3, 0, 1));
+            return _mm_or_si128(_mm_slli_epi16(Value, 8), _mm_srli_epi16(Value, 8));
+        }
+
+        // 16x16 字节块转置：4 轮 unpack，每轮把交错粒度翻倍
+        inline void TransposeBlock16(const uint8_t* Src, int32_t SrcStride, uint8_t* Dst, int32_t DstStride)
+        {
+            __m128i Rows[16];
+            for (int32_t i = 0; i < 16; i++)
+            {
+                Rows[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + i * SrcStride));
+            }
+
+            __m128i Temp[16];
+            for (int32_t i = 0; i < 8; i++)
+            {
+                Temp[i] = _mm_unpacklo_epi8(Rows[2 * i], Rows[2 * i + 1]);
+                Temp[i + 8] = _mm_unpackhi_epi8(Rows[2 * i], Rows[2 * i + 1]);
+            }
+            for (int32_t Half = 0; Half < 16; Half += 8)
+            {
+                for (int32_t i = 0; i < 4; i++)
+                {
+                    Rows[Half + i] = _mm_unpacklo_epi16(Temp[Half + 2 * i], Temp[Half + 2 * i + 1]);
+                    Rows[Half + i + 4] = _mm_unpackhi_epi16(Temp[Half + 2 * i], Temp[Half + 2 * i + 1]);
+                }
+            }
+            for (int32_t Quarter = 0; Quarter < 16; Quarter += 4)
+            {
+                for (int32_t i = 0; i < 2; i++)
+                {
+                    Temp[Quarter + i] = _mm_unpacklo_epi32(Rows[Quarter + 2 * i], Rows[Quarter + 2 * i + 1]);
+                    Temp[Quarter + i + 2] = _mm_unpackhi_epi32(Rows[Quarter + 2 * i], Rows[Quarter + 2 * i + 1]);
+                }
+            }
+            for (int32_t Pair = 0; Pair < 16; Pair += 2)
+            {
+                Rows[Pair] = _mm_unpacklo_epi64(Temp[Pair], Temp[Pair + 1]);
+                Rows[Pair + 1] = _mm_unpackhi_epi64(Temp[Pair], Temp[Pair + 1]);
+            }
+
+            // 经过上面 4 轮，第 i 个寄存器正好是源块的第 i 列
+            for (int32_t i = 0; i < 16; i++)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + i * DstStride), Rows[i]);
+            }
+        }
+#endif
+
+        // Dst[i] = Src[Count - 1 - i]，两者不能重叠
+        inline void ReverseCopy(uint8_t* Dst, const uint8_t* Src, int32_t Count)
+        {
+            int32_t i = 0;
+#if MAGICCUBE_FACELETS_SSE2
+            for (; i + 16 <= Count; i += 16)
+            {
+                const __m128i Value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + Count - 16 - i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + i), Reverse16(Value));
+            }
+#endif
+            for (; i < Count; i++)
+            {
+                Dst[i] = Src[Count - 1 - i];
+            }
+        }
+
+        // 原地倒序（面转 180°）
+        inline void ReverseInPlace(uint8_t* Data, int32_t Count)
+        {
+            int32_t Front = 0;
+            int32_t Back = Count;
+#if MAGICCUBE_FACELETS_SSE2
+            for (; Back - Front >= 32; Front += 16, Back -= 16)
+            {
+                const __m128i Head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + Front));
+                const __m128i Tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + Back - 16));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(Data + Front), Reverse16(Tail));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(Data + Back - 16), Reverse16(Head));
+            }
+#endif
+            for (Back--; Front < Back; Front++, Back--)
+            {
+                const uint8_t Temp = Data[Front];
+                Data[Front] = Data[Back];
+                Data[Back] = Temp;
+            }
+        }
+
+        // N x N 转置，Dst 与 Src 不能重叠
+        inline void Transpose(uint8_t* Dst, const uint8_t* Src, int32_t N)
+        {
+            int32_t BlockEnd = 0;
+#if MAGICCUBE_FACELETS_SSE2
+            BlockEnd = N & ~15;
+            for (int32_t Row = 0; Row < BlockEnd; Row += 16)
+            {
+                for (int32_t Col = 0; Col < BlockEnd; Col += 16)
+                {
+                    TransposeBlock16(Src + Row * N + Col, N, Dst + Col * N + Row, N);
+                }
+            }
+#endif
+            // 不足 16 的边角：右侧竖条和底部横条
+            for (int32_t Row = 0; Row < N; Row++)
+            {
+                const int32_t ColStart = Row < BlockEnd ? BlockEnd : 0;
+                for (int32_t Col = ColStart; Col < N; Col++)
+                {
+                    Dst[Col * N + Row] = Src[Row * N + Col];
+                }
+            }
+        }
+    }
+
+    class FFaceletCube
+    {
+    public:
+        static constexpr int32_t NumFaces = 6;
+
+        static constexpr int32_t GetFaceIndex(int32_t AxisIndex, bool bPositive) { return AxisIndex * 2 + (bPositive ? 0 : 1); }
+
+        // 只支持 N x N x N，Order <= 0 表示不启用
+        void Initialize(int32_t InOrder)
+        {
+            Order = InOrder > 0 ? InOrder : 0;
+            FaceSize = Order * Order;
+            Scratch.assign(static_cast<size_t>(FaceSize > 4 * Order ? FaceSize : 4 * Order), 0);
+            Reset();
+        }
+
+        void Reset()
+        {
+            Stickers.resize(static_cast<size_t>(NumFaces * FaceSize));
+            for (int32_t Face = 0; Face < NumFaces; Face++)
+            {
+                std::memset(Stickers.data() + Face * FaceSize, Face, static_cast<size_t>(FaceSize));
+            }
+        }
+
+        bool IsValid() const { return Order > 0; }
+        int32_t GetOrder() const { return Order; }
+
+        const uint8_t* GetFaceData(int32_t Face) const { return Stickers.data() + Face * FaceSize; }
+        uint8_t GetSticker(int32_t Face, int32_t U, int32_t V) const { return Stickers[Face * FaceSize + U + V * Order]; }
+
+        // 与 FCubeState::ApplyMove 相同的约定；立方体上所有转动都合法，只检查范围
+        bool ApplyMove(int32_t AxisIndex, int32_t Layer, int32_t QuarterTurns)
+        {
+            if (!IsValid() || AxisIndex < 0 || AxisIndex > 2 || Layer < 0 || Layer >= Order)
+            {
+                return false;
+            }
+
+            const int32_t Turns = NormalizeQuarterTurns(QuarterTurns);
+            if (Turns == 0)
+            {
+                return true;
+            }
+
+            CycleLayerStrips(AxisIndex, Layer, Turns);
+            if (Layer == Order - 1)
+            {
+                RotateFace(GetFaceIndex(AxisIndex, true), Turns);
+            }
+            if (Layer == 0)
+            {
+                RotateFace(GetFaceIndex(AxisIndex, false), Turns);
+            }
+            return true;
+        }
+
+        int32_t ApplyMoves(const FLayerTurn* Moves, int32_t NumMoves)
+        {
+            int32_t Applied = 0;
+            for (int32_t MoveIndex = 0; MoveIndex < NumMoves; MoveIndex++)
+            {
+                Applied += ApplyMove(Moves[MoveIndex].AxisIndex, Moves[MoveIndex].Layer, Moves[MoveIndex].QuarterTurns) ? 1 : 0;
+            }
+            return Applied;
+        }
+
+    private:
+        int32_t Order = 0;
+        int32_t FaceSize = 0;
+        std::vector<uint8_t> Stickers;
+        std::vector<uint8_t> Scratch;
+
+        // 转动轴 A 的层 L 在四个侧面上各占一条贴纸带，设 U=(A+1)%3、V=(A+2)%3：
+        // ±U 面上是一行（连续），±V 面上是一列（步长 N）
+        // +90° 时 +U -> +V -> -U -> -V -> +U，按下面的读取方向取出后，第 t 张正好落到下一条带的第 t 张
+        void GetStrip(int32_t AxisIndex, int32_t Layer, int32_t StripIndex, int32_t& OutStart, int32_t& OutStride) const
+        {
+            const int32_t U = (AxisIndex + 1) % 3;
+            const int32_t V = (AxisIndex + 2) % 3;
+            switch (StripIndex)
+            {
+                case 0: // +U 面第 L 行，正向
+                    OutStart = GetFaceIndex(U, true) * FaceSize + Layer * Order;
+                    OutStride = 1;
+                    break;
+                case 1: // +V 面第 L 列，反向
+                    OutStart = GetFaceIndex(V, true) * FaceSize + Layer + (Order - 1) * Order;
+                    OutStride = -Order;
+                    break;
+                case 2: // -U 面第 L 行，反向
+                    OutStart = GetFaceIndex(U, false) * FaceSize + Layer * Order + Order - 1;
+                    OutStride = -1;
+                    break;
+                default: // -V 面第 L 列，正向
+                    OutStart = GetFaceIndex(V, false) * FaceSize + Layer;
+                    OutStride = Order;
+                    break;
+            }
+        }
+
+        void CycleLayerStrips(int32_t AxisIndex, int32_t Layer, int32_t Turns)
+        {
+            uint8_t* Data = Stickers.data();
+            uint8_t* Strips = Scratch.data();
+
+            // 先全部读出，再写到 Turns 条之后的带上
+            for (int32_t StripIndex = 0; StripIndex < 4; StripIndex++)
+            {
+                int32_t Start = 0;
+                int32_t Stride = 0;
+                GetStrip(AxisIndex, Layer, StripIndex, Start, Stride);
+                uint8_t* Strip = Strips + StripIndex * Order;
+                if (Stride == 1)
+                {
+                    std::memcpy(Strip, Data + Start, static_cast<size_t>(Order));
+                }
+                else if (Stride == -1)
+                {
+                    FaceletKernels::ReverseCopy(Strip, Data + Start - (Order - 1), Order);
+                }
+                else
+                {
+                    for (int32_t t = 0; t < Order; t++)
+                    {
+                        Strip[t] = Data[Start + t * Stride];
+                    }
+                }
+            }
+
+            for (int32_t StripIndex = 0; StripIndex < 4; StripIndex++)
+            {
+                int32_t Start = 0;
+                int32_t Stride = 0;
+                GetStrip(AxisIndex, Layer, (StripIndex + Turns) & 3, Start, Stride);
+                const uint8_t* Strip = Strips + StripIndex * Order;
+                if (Stride == 1)
+                {
+                    std::memcpy(Data + Start, Strip, static_cast<size_t>(Order));
+                }
+                else if (Stride == -1)
+                {
+                    FaceletKernels::ReverseCopy(Data + Start - (Order - 1), Strip, Order);
+                }
+                else
+                {
+                    for (int32_t t = 0; t < Order; t++)
+                    {
+                        Data[Start + t * Stride] = Strip[t];
+                    }
+                }
+            }
+        }
+
+        // 面内旋转：(u, v) -> (N-1-v, u)，即 +90° = 转置后每行倒序，-90° = 转置后行序倒序，180° = 整体倒序
+        void RotateFace(int32_t Face, int32_t Turns)
+        {
+            uint8_t* FaceData = Stickers.data() + Face * FaceSize;
+            if (Turns == 2)
+            {
+                FaceletKernels::ReverseInPlace(FaceData, FaceSize);
+                return;
+            }
+
+            uint8_t* Transposed = Scratch.data();
+            FaceletKernels::Transpose(Transposed, FaceData, Order);
+            for (int32_t Row = 0; Row < Order; Row++)
+            {
+                if (Turns == 1)
+                {
+                    FaceletKernels::ReverseCopy(FaceData + Row * Order, Transposed + Row * Order, Order);
+                }
+                else
+                {
+                    std::memcpy(FaceData + Row * Order, Transposed + (Order - 1 - Row) * Order, static_cast<size_t>(Order));
+                }
+            }
+        }
+    };
+}
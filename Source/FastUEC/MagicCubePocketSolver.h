@@ -0,0 +1,366 @@
+#pragma once
+
+// Teng：2 阶魔方的最优解求解器（纯逻辑，不依赖引擎）
+// 固定槽位 0 上的角块不动（先整体转到它的初始朝向），剩下 7 个角块的排列 7! × 朝向 3^6 = 3674160 个状态，
+// 距离表对全部状态广度优先一次算出（每个状态 4 位），IDA* 以它为启发函数，因此是精确的，搜索不会回溯
+// 距离表由外部提供内存（例如磁盘缓存的内存映射），求解器本身只持有很小的转动表
+
+#include "MagicCubeCore.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MagicCube
+{
+    class FPocketCubeSolver
+    {
+    public:
+        static constexpr int32_t NumCorners = 8;
+        static constexpr int32_t NumPermutations = 5040;
+        static constexpr int32_t NumTwists = 729;
+        static constexpr int32_t NumStates = NumPermutations * NumTwists;
+        static constexpr int32_t NumMoves = 9; // 三个轴各自正向那一层，转 1/2/3 次
+        static constexpr int32_t DistanceTableBytes = (NumStates + 1) / 2;
+        static constexpr int32_t MaxSolutionLength = 14;
+
+        FPocketCubeSolver()
+        {
+            BuildMoveTables();
+        }
+
+        // 对全部状态广度优先，写出距离表（每个状态 4 位，低位在前）
+        void BuildDistanceTable(uint8_t* OutTable) const
+        {
+            for (int32_t i = 0; i < DistanceTableBytes; i++)
+            {
+                OutTable[i] = 0xFF;
+            }
+
+            std::vector<uint32_t> Queue;
+            Queue.reserve(NumStates);
+            Queue.push_back(0);
+            SetDistance(OutTable, 0, 0);
+            for (std::size_t Head = 0; Head < Queue.size(); Head++)
+            {
+                const int32_t State = static_cast<int32_t>(Queue[Head]);
+                const int32_t Permutation = State / NumTwists;
+                const int32_t Twist = State % NumTwists;
+                const uint8_t NextDistance = static_cast<uint8_t>(GetDistance(OutTable, State) + 1);
+                for (int32_t Move = 0; Move < NumMoves; Move++)
+                {
+                    const int32_t Next = PermutationMoves[Permutation][Move] * NumTwists + TwistMoves[Twist][Move];
+                    if (GetDistance(OutTable, Next) == 0xF)
+                    {
+                        SetDistance(OutTable, Next, NextDistance);
+                        Queue.push_back(static_cast<uint32_t>(Next));
+                    }
+                }
+            }
+        }
+
+        // 距离表的内存需在求解器的整个使用期内有效
+        void SetDistanceTable(const uint8_t* InTable) { DistanceTable = InTable; }
+        bool IsReady() const { return DistanceTable != nullptr; }
+
+        // 求出让 State 还原的最短转动序列（以 State 自己的坐标系表达，可以直接逐步转动）
+        // State 必须是没有空槽的 2x2x2；已还原时返回 true 且 OutMoves 为空；Control 可选，用于取消和进度
+        bool Solve(const FCubeState& State, std::vector<FLayerTurn>& OutMoves, FSearchControl* Control = nullptr) const
+        {
+            OutMoves.clear();
+            if (!IsReady() || State.GetFixedOrder() != 2)
+            {
+                return false;
+            }
+
+            // 整体转动 W 让方块 0 回到初始朝向，此时它也必然回到槽位 0
+            const uint8_t Orientation0 = State.GetCubieOrientation(0);
+            uint8_t Normalize = 0;
+            while (OrientationTable.Compose[Normalize][Orientation0] != 0)
+            {
+                Normalize++;
+            }
+
+            int32_t CubieAtSlot[NumCorners] = {};
+            int32_t TwistAtSlot[NumCorners] = {};
+            for (int32_t Cubie = 0; Cubie < NumCorners; Cubie++)
+            {
+                const int32_t Slot = State.RotateSlot(State.GetCubieSlot(Cubie), Normalize);
+                const uint8_t Orientation = OrientationTable.Compose[Normalize][State.GetCubieOrientation(Cubie)];
+                CubieAtSlot[Slot] = Cubie;
+                TwistAtSlot[Slot] = GetTwist(Slot, State.GetCubieHomeSlot(Cubie), Orientation);
+            }
+
+            int32_t Permutation = EncodePermutation(CubieAtSlot);
+            int32_t Twist = EncodeTwist(TwistAtSlot);
+
+            // IDA*：启发函数是精确距离，第一轮就会找到解
+            int32_t Path[MaxSolutionLength] = {};
+            int32_t Length = -1;
+            for (int32_t Bound = Lookup(Permutation, Twist); Bound <= MaxSolutionLength && Length < 0; Bound++)
+            {
+                if (Control != nullptr)
+                {
+                    if (Control->IsCancelled())
+                    {
+                        return false;
+                    }
+                    Control->SetDepth(Bound);
+                }
+                int64_t Nodes = 0;
+                Length = Search(Permutation, Twist, 0, Bound, -1, Path, Nodes);
+                if (Control != nullptr)
+                {
+                    Control->AddNodes(Nodes);
+                }
+            }
+            if (Length < 0)
+            {
+                return false;
+            }
+
+            // 把规范化坐标系下的转动换回原坐标系：绕 +e_a 的正向层，在原坐标系里是绕 Orientation0 * e_a 的那一层
+            const int32_t (&M)[3][3] = OrientationTable.Matrices[Orientation0];
+            for (int32_t i = 0; i < Length; i++)
+            {
+                const int32_t Axis = Path[i] / 3;
+                const int32_t Turns = Path[i] % 3 + 1;
+                for (int32_t TargetAxis = 0; TargetAxis < 3; TargetAxis++)
+                {
+                    const int32_t Sign = M[TargetAxis][Axis];
+                    if (Sign != 0)
+                    {
+                        const int32_t SignedTurns = Turns == 3 ? -1 : Turns;
+                        OutMoves.push_back(FLayerTurn{ TargetAxis, Sign > 0 ? 1 : 0, Sign > 0 ? SignedTurns : (SignedTurns == 2 ? 2 : -SignedTurns) });
+                    }
+                }
+            }
+            return true;
+        }
+
+    private:
+        uint16_t PermutationMoves[NumPermutations][NumMoves] = {};
+        uint16_t TwistMoves[NumTwists][NumMoves] = {};
+        const uint8_t* DistanceTable = nullptr;
+
+        // 每个角槽位的三个面，按从外面看的同一旋向排列，第一个总是 Z 方向的面
+        // 角块的朝向 = 它初始时 Z 方向那张贴纸现在在列表中的位置，所有角块之和始终是 3 的倍数
+        static void GetSlotFaces(int32_t Slot, int32_t OutFaces[3])
+        {
+            const int32_t X = Slot & 1;
+            const int32_t Y = (Slot >> 1) & 1;
+            const int32_t Z = (Slot >> 2) & 1;
+            const int32_t FaceX = X ? 0 : 1;
+            const int32_t FaceY = Y ? 2 : 3;
+            const int32_t FaceZ = Z ? 4 : 5;
+            const bool bRightHanded = ((X + Y + Z) & 1) == 1; // 三个符号之积为正
+            OutFaces[0] = FaceZ;
+            OutFaces[1] = bRightHanded ? FaceX : FaceY;
+            OutFaces[2] = bRightHanded ? FaceY : FaceX;
+        }
+
+        static int32_t RotateFace(int32_t Face, const int32_t (&M)[3][3])
+        {
+            const int32_t Axis = Face / 2;
+            const int32_t Sign = (Face % 2 == 0) ? 1 : -1;
+            for (int32_t Row = 0; Row < 3; Row++)
+            {
+                if (M[Row][Axis] != 0)
+                {
+                    return Row * 2 + (Sign * M[Row][Axis] > 0 ? 0 : 1);
+                }
+            }
+            return Face;
+        }
+
+        static int32_t GetTwist(int32_t Slot, int32_t HomeSlot, uint8_t Orientation)
+        {
+            const int32_t HomeFaceZ = ((HomeSlot >> 2) & 1) ? 4 : 5;
+            const int32_t Face = RotateFace(HomeFaceZ, OrientationTable.Matrices[Orientation]);
+            int32_t Faces[3];
+            GetSlotFaces(Slot, Faces);
+            return Face == Faces[0] ? 0 : (Face == Faces[1] ? 1 : 2);
+        }
+
+        // 槽位 1..7 上的方块编号 1..7 的排列，Lehmer 编码
+        static int32_t EncodePermutation(const int32_t CubieAtSlot[NumCorners])
+        {
+            int32_t Index = 0;
+            for (int32_t i = 1; i < NumCorners; i++)
+            {
+                int32_t Smaller = 0;
+                for (int32_t j = i + 1; j < NumCorners; j++)
+                {
+                    Smaller += CubieAtSlot[j] < CubieAtSlot[i] ? 1 : 0;
+                }
+                Index = Index * (NumCorners - i) + Smaller;
+            }
+            return Index;
+        }
+
+        static void DecodePermutation(int32_t Index, int32_t OutCubieAtSlot[NumCorners])
+        {
+            int32_t Codes[NumCorners] = {};
+            for (int32_t i = NumCorners - 1; i >= 1; i--)
+            {
+                Codes[i] = Index % (NumCorners - i);
+                Index /= NumCorners - i;
+            }
+
+            bool bUsed[NumCorners] = {};
+            OutCubieAtSlot[0] = 0;
+            for (int32_t i = 1; i < NumCorners; i++)
+            {
+                int32_t Cubie = 1;
+                for (int32_t Skip = Codes[i]; bUsed[Cubie] || Skip > 0; Cubie++)
+                {
+                    Skip -= bUsed[Cubie] ? 0 : 1;
+                }
+                bUsed[Cubie] = true;
+                OutCubieAtSlot[i] = Cubie;
+            }
+        }
+
+        // 槽位 1..6 的朝向按三进制编码，槽位 7 由总和推出
+        static int32_t EncodeTwist(const int32_t TwistAtSlot[NumCorners])
+        {
+            int32_t Index = 0;
+            for (int32_t Slot = NumCorners - 2; Slot >= 1; Slot--)
+            {
+                Index = Index * 3 + TwistAtSlot[Slot];
+            }
+            return Index;
+        }
+
+        static void DecodeTwist(int32_t Index, int32_t OutTwistAtSlot[NumCorners])
+        {
+            int32_t Sum = 0;
+            OutTwistAtSlot[0] = 0;
+            for (int32_t Slot = 1; Slot <= NumCorners - 2; Slot++)
+            {
+                OutTwistAtSlot[Slot] = Index % 3;
+                Sum += Index % 3;
+                Index /= 3;
+            }
+            OutTwistAtSlot[NumCorners - 1] = (3 - Sum % 3) % 3;
+        }
+
+        void BuildMoveTables()
+        {
+            // 先算出每个转动对槽位和朝向的作用，再展开成坐标上的转动表
+            int32_t SlotTargets[NumMoves][NumCorners] = {};
+            int32_t TwistTargets[NumMoves][NumCorners][3] = {};
+            for (int32_t Move = 0; Move < NumMoves; Move++)
+            {
+                const int32_t Axis = Move / 3;
+                const int32_t (&M)[3][3] = OrientationTable.Matrices[OrientationTable.QuarterTurns[Axis][Move % 3 + 1]];
+                for (int32_t Slot = 0; Slot < NumCorners; Slot++)
+                {
+                    const bool bInLayer = ((Slot >> Axis) & 1) == 1;
+                    int32_t Target = Slot;
+                    if (bInLayer)
+                    {
+                        Target = 0;
+                        for (int32_t Row = 0; Row < 3; Row++)
+                        {
+                            int32_t Doubled = 0;
+                            for (int32_t Col = 0; Col < 3; Col++)
+                            {
+                                Doubled += M[Row][Col] * (((Slot >> Col) & 1) * 2 - 1);
+                            }
+                            Target |= (Doubled > 0 ? 1 : 0) << Row;
+                        }
+                    }
+                    SlotTargets[Move][Slot] = Target;
+
+                    int32_t Faces[3];
+                    int32_t TargetFaces[3];
+                    GetSlotFaces(Slot, Faces);
+                    GetSlotFaces(Target, TargetFaces);
+                    for (int32_t Twist = 0; Twist < 3; Twist++)
+                    {
+                        const int32_t Face = bInLayer ? RotateFace(Faces[Twist], M) : Faces[Twist];
+                        TwistTargets[Move][Slot][Twist] = Face == TargetFaces[0] ? 0 : (Face == TargetFaces[1] ? 1 : 2);
+                    }
+                }
+            }
+
+            for (int32_t Permutation = 0; Permutation < NumPermutations; Permutation++)
+            {
+                int32_t CubieAtSlot[NumCorners];
+                DecodePermutation(Permutation, CubieAtSlot);
+                for (int32_t Move = 0; Move < NumMoves; Move++)
+                {
+                    int32_t Moved[NumCorners];
+                    for (int32_t Slot = 0; Slot < NumCorners; Slot++)
+                    {
+                        Moved[SlotTargets[Move][Slot]] = CubieAtSlot[Slot];
+                    }
+                    PermutationMoves[Permutation][Move] = static_cast<uint16_t>(EncodePermutation(Moved));
+                }
+            }
+
+            for (int32_t Twist = 0; Twist < NumTwists; Twist++)
+            {
+                int32_t TwistAtSlot[NumCorners];
+                DecodeTwist(Twist, TwistAtSlot);
+                for (int32_t Move = 0; Move < NumMoves; Move++)
+                {
+                    int32_t Moved[NumCorners];
+                    for (int32_t Slot = 0; Slot < NumCorners; Slot++)
+                    {
+                        Moved[SlotTargets[Move][Slot]] = TwistTargets[Move][Slot][TwistAtSlot[Slot]];
+                    }
+                    TwistMoves[Twist][Move] = static_cast<uint16_t>(EncodeTwist(Moved));
+                }
+            }
+        }
+
+        static uint8_t GetDistance(const uint8_t* Table, int32_t State)
+        {
+            return (Table[State >> 1] >> ((State & 1) * 4)) & 0xF;
+        }
+
+        static void SetDistance(uint8_t* Table, int32_t State, uint8_t Distance)
+        {
+            const int32_t Shift = (State & 1) * 4;
+            Table[State >> 1] = static_cast<uint8_t>((Table[State >> 1] & ~(0xF << Shift)) | (Distance << Shift));
+        }
+
+        int32_t Lookup(int32_t Permutation, int32_t Twist) const
+        {
+            return GetDistance(DistanceTable, Permutation * NumTwists + Twist);
+        }
+
+        // 返回找到的解长度，找不到返回 -1
+        int32_t Search(int32_t Permutation, int32_t Twist, int32_t Depth, int32_t Bound, int32_t LastAxis, int32_t Path[MaxSolutionLength], int64_t& Nodes) const
+        {
+            Nodes++;
+            const int32_t Estimate = Lookup(Permutation, Twist);
+            if (Estimate == 0)
+            {
+                return Depth;
+            }
+            if (Depth + Estimate > Bound)
+            {
+                return -1;
+            }
+
+            for (int32_t Move = 0; Move < NumMoves; Move++)
+            {
+                // 同一轴连续转动可以合并，跳过
+                if (Move / 3 == LastAxis)
+                {
+                    continue;
+                }
+                Path[Depth] = Move;
+                const int32_t Length = Search(PermutationMoves[Permutation][Move], TwistMoves[Twist][Move], Depth + 1, Bound, Move / 3, Path, Nodes);
+                if (Length >= 0)
+                {
+                    return Length;
+                }
+            }
+            return -1;
+        }
+    };
+}
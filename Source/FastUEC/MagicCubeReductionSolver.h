@@ -0,0 +1,655 @@
+#pragma once
+
+// Teng：大阶魔方（N >= 4）的降阶法求解器（纯逻辑，不依赖引擎）
+// 在 FFaceletCube 的副本上一边求解一边通过回调输出每一步，调用方可以在求解结束前就开始播放
+//   0. 定色：奇数阶以固定中心为准，偶数阶按初始配色
+//   1. 奇偶：每个棱块轨道的置换为奇时先转一次该内层；偶数阶角块置换为奇时先转一次外层
+//   2. 中心：逐面逐块，用 S·[A, F·Z·F']·S' 形式的纯三循环把颜色正确的中心块换进来
+//   3. 三阶阶段：角块和奇数阶的中棱交给两阶段求解器，只用外层转动
+//   4. 棱：逐个把棱块（wing）送回原位，配对随之完成；三循环形式同上，Z 换成外层，不会再动到角块、中棱和中心
+// 棱放在三阶阶段之后，两者互不干扰，也就不需要偶数阶的 OLL/PLL 奇偶公式（奇偶已在第 1 步调好）
+// A 与 F·Z·F' 的作用范围只交于目标块，换位子就只循环三块、其他一律复原；S 是把来源块送到位的准备步骤（用贴纸位置做小范围搜索）
+// 只保存一份贴纸副本和一张按贴纸数分配的标记表，内存随 N² 线性增长
+
+#include "MagicCubeCore.h"
+#include "MagicCubeFacelets.h"
+#include "MagicCubeTwoPhaseSolver.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <unordered_set>
+#include <vector>
+
+namespace MagicCube
+{
+    class FReductionSolver
+    {
+    public:
+        using FEmitMove = std::function<void(const FLayerTurn&)>;
+
+        static constexpr int32_t MinOrder = 4;
+        static constexpr int32_t MaxSetupMoves = 4;
+        static constexpr int32_t FinalPhaseTargetLength = 23;
+
+        // 最后的三阶阶段借用两阶段求解器，需已就绪
+        explicit FReductionSolver(const FTwoPhaseSolver& InThreeByThree)
+            : ThreeByThree(InThreeByThree)
+        {
+        }
+
+        // 从 Start 求解到还原（奇数阶以固定中心为准，可能整体转了方向），每一步都立即交给 Emit
+        // Control 可选：取消后在下一个三循环前返回 false，已经输出的步骤不会撤回；进度里的深度是当前步骤（1..4），节点数是准备步骤的搜索节点
+        bool Solve(const FFaceletCube& Start, const FEmitMove& Emit, FSearchControl* Control = nullptr)
+        {
+            if (!Start.IsValid() || Start.GetOrder() < MinOrder || !ThreeByThree.IsReady())
+            {
+                return false;
+            }
+
+            Cube = Start;
+            N = Cube.GetOrder();
+            FaceSize = N * N;
+            EmitMove = &Emit;
+            SearchControl = Control;
+            Solved.assign(static_cast<size_t>(FFaceletCube::NumFaces * FaceSize), 0);
+
+            ChooseFaceColours();
+            SetStage(1);
+            FixParity();
+            return SetStage(2) && SolveCenters()
+                && SetStage(3) && SolveThreeByThree()
+                && SetStage(4) && SolveWings();
+        }
+
+    private:
+        struct FSticker
+        {
+            int32_t Face = 0;
+            int32_t Coords[3] = {};
+        };
+
+        // 三循环 [A, B]，B = Y · Z · Y'
+        struct FCommutator
+        {
+            FLayerTurn A;
+            FLayerTurn Y;
+            FLayerTurn Z;
+        };
+
+        const FTwoPhaseSolver& ThreeByThree;
+        FFaceletCube Cube;
+        int32_t N = 0;
+        int32_t FaceSize = 0;
+        const FEmitMove* EmitMove = nullptr;
+        FSearchControl* SearchControl = nullptr;
+
+        uint8_t FaceColours[FFaceletCube::NumFaces] = {};
+        int32_t ColourFaces[FFaceletCube::NumFaces] = {};
+
+        // 已还原、不能再被三循环动到的贴纸位置
+        std::vector<uint8_t> Solved;
+
+        // 准备步骤搜索的工作区
+        struct FSetupNode
+        {
+            int32_t Source = 0;
+            int32_t Free = 0;
+            int32_t Parent = -1;
+            FLayerTurn Move;
+            int32_t Depth = 0;
+        };
+        std::vector<FSetupNode> SetupNodes;
+        std::unordered_set<int64_t> SetupVisited;
+        std::vector<FCommutator> Candidates;
+
+        // ---- 贴纸位置 ----
+
+        bool IsCancelled() const { return SearchControl != nullptr && SearchControl->IsCancelled(); }
+
+        bool SetStage(int32_t Stage)
+        {
+            if (SearchControl != nullptr)
+            {
+                SearchControl->SetDepth(Stage);
+            }
+            return !IsCancelled();
+        }
+
+        int32_t GetEnd(int32_t Face) const { return Face % 2 == 0 ? N - 1 : 0; }
+
+        FSticker Decode(int32_t Position) const
+        {
+            FSticker Sticker;
+            Sticker.Face = Position / FaceSize;
+            const int32_t Axis = Sticker.Face / 2;
+            const int32_t Index = Position % FaceSize;
+            Sticker.Coords[Axis] = GetEnd(Sticker.Face);
+            Sticker.Coords[(Axis + 1) % 3] = Index % N;
+            Sticker.Coords[(Axis + 2) % 3] = Index / N;
+            return Sticker;
+        }
+
+        int32_t Encode(int32_t Face, const int32_t Coords[3]) const
+        {
+            const int32_t Axis = Face / 2;
+            return Face * FaceSize + Coords[(Axis + 1) % 3] + Coords[(Axis + 2) % 3] * N;
+        }
+
+        uint8_t GetColour(int32_t Position) const
+        {
+            return Cube.GetFaceData(Position / FaceSize)[Position % FaceSize];
+        }
+
+        bool IsMovedBy(int32_t Position, const FLayerTurn& Move) const
+        {
+            return Decode(Position).Coords[Move.AxisIndex] == Move.Layer;
+        }
+
+        // 转动后这张贴纸所在的位置；与 FFaceletCube 用同一套旋转矩阵
+        int32_t MovePosition(int32_t Position, const FLayerTurn& Move) const
+        {
+            const FSticker Sticker = Decode(Position);
+            const int32_t Turns = NormalizeQuarterTurns(Move.QuarterTurns);
+            if (Sticker.Coords[Move.AxisIndex] != Move.Layer || Turns == 0)
+            {
+                return Position;
+            }
+
+            const int32_t (&M)[3][3] = OrientationTable.Matrices[OrientationTable.QuarterTurns[Move.AxisIndex][Turns]];
+            int32_t Coords[3] = {};
+            for (int32_t Row = 0; Row < 3; Row++)
+            {
+                int32_t Doubled = 0;
+                for (int32_t Col = 0; Col < 3; Col++)
+                {
+                    Doubled += M[Row][Col] * (2 * Sticker.Coords[Col] - (N - 1));
+                }
+                Coords[Row] = (Doubled + N - 1) / 2;
+            }
+
+            const int32_t Axis = Sticker.Face / 2;
+            const int32_t Sign = Sticker.Face % 2 == 0 ? 1 : -1;
+            int32_t Face = Sticker.Face;
+            for (int32_t Row = 0; Row < 3; Row++)
+            {
+                if (M[Row][Axis] != 0)
+                {
+                    Face = Row * 2 + (Sign * M[Row][Axis] > 0 ? 0 : 1);
+                }
+            }
+            return Encode(Face, Coords);
+        }
+
+        static FLayerTurn Inverse(const FLayerTurn& Move)
+        {
+            return FLayerTurn{ Move.AxisIndex, Move.Layer, -Move.QuarterTurns };
+        }
+
+        // 三循环的 8 步：A, Y, Z, Y', A', Y, Z', Y'
+        static void GetCommutatorMoves(const FCommutator& Commutator, FLayerTurn OutMoves[8])
+        {
+            OutMoves[0] = Commutator.A;
+            OutMoves[1] = Commutator.Y;
+            OutMoves[2] = Commutator.Z;
+            OutMoves[3] = Inverse(Commutator.Y);
+            OutMoves[4] = Inverse(Commutator.A);
+            OutMoves[5] = Commutator.Y;
+            OutMoves[6] = Inverse(Commutator.Z);
+            OutMoves[7] = Inverse(Commutator.Y);
+        }
+
+        void Emit(const FLayerTurn& Move)
+        {
+            Cube.ApplyMove(Move.AxisIndex, Move.Layer, Move.QuarterTurns);
+            (*EmitMove)(Move);
+        }
+
+        // ---- 0、1：定色与奇偶 ----
+
+        void ChooseFaceColours()
+        {
+            for (int32_t Face = 0; Face < FFaceletCube::NumFaces; Face++)
+            {
+                FaceColours[Face] = (N % 2 == 1) ? Cube.GetSticker(Face, N / 2, N / 2) : static_cast<uint8_t>(Face);
+                ColourFaces[FaceColours[Face]] = Face;
+            }
+        }
+
+        static int32_t GetPermutationParity(const std::vector<int32_t>& Targets)
+        {
+            int32_t Parity = 0;
+            std::vector<uint8_t> Visited(Targets.size(), 0);
+            for (size_t Start = 0; Start < Targets.size(); Start++)
+            {
+                for (size_t Index = Start; !Visited[Index]; Index = static_cast<size_t>(Targets[Index]))
+                {
+                    Visited[Index] = 1;
+                    Parity ^= (Index != Start) ? 1 : 0;
+                }
+            }
+            return Parity;
+        }
+
+        // 某个棱块轨道（第 Layer 与 N-1-Layer 层）的全部贴纸位置，每块只取面下标较小的那张
+        void GetWingSlots(int32_t Layer, std::vector<int32_t>& OutSlots) const
+        {
+            OutSlots.clear();
+            for (int32_t Face = 0; Face < FFaceletCube::NumFaces; Face++)
+            {
+                const int32_t Axis = Face / 2;
+                for (int32_t Other = Face + 1; Other < FFaceletCube::NumFaces; Other++)
+                {
+                    if (Other / 2 == Axis)
+                    {
+                        continue;
+                    }
+                    const int32_t EdgeAxis = 3 - Axis - Other / 2;
+                    for (int32_t Along : { Layer, N - 1 - Layer })
+                    {
+                        int32_t Coords[3] = {};
+                        Coords[Axis] = GetEnd(Face);
+                        Coords[Other / 2] = GetEnd(Other);
+                        Coords[EdgeAxis] = Along;
+                        OutSlots.push_back(Encode(Face, Coords));
+                    }
+                }
+            }
+        }
+
+        int32_t GetWingPartner(int32_t Position) const
+        {
+            const FSticker Sticker = Decode(Position);
+            for (int32_t Axis = 0; Axis < 3; Axis++)
+            {
+                if (Axis != Sticker.Face / 2 && (Sticker.Coords[Axis] == 0 || Sticker.Coords[Axis] == N - 1))
+                {
+                    return Encode(Axis * 2 + (Sticker.Coords[Axis] == 0 ? 1 : 0), Sticker.Coords);
+                }
+            }
+            return Position;
+        }
+
+        // 两个面法线与棱方向构成的行列式符号（法线带方向，棱方向取正轴）
+        static int32_t GetHandedness(int32_t FaceA, int32_t FaceB)
+        {
+            const int32_t AxisA = FaceA / 2;
+            const int32_t AxisB = FaceB / 2;
+            const int32_t Sign = ((FaceA % 2 == 0) ? 1 : -1) * ((FaceB % 2 == 0) ? 1 : -1);
+            return (AxisB == (AxisA + 1) % 3) ? Sign : -Sign;
+        }
+
+        // 这张棱块贴纸在还原状态下的位置：颜色决定所在的两个面，镜像的两块（第 k 与 N-1-k 层）靠手性区分
+        int32_t GetWingHome(int32_t Position) const
+        {
+            const FSticker Sticker = Decode(Position);
+            const int32_t Partner = GetWingPartner(Position);
+            const int32_t PartnerFace = Partner / FaceSize;
+            const int32_t EdgeAxis = 3 - Sticker.Face / 2 - PartnerFace / 2;
+            const int32_t Offset = 2 * Sticker.Coords[EdgeAxis] - (N - 1);
+            const int32_t Chirality = GetHandedness(Sticker.Face, PartnerFace) * Offset;
+
+            const int32_t HomeFace = ColourFaces[GetColour(Position)];
+            const int32_t HomePartnerFace = ColourFaces[GetColour(Partner)];
+            if (HomeFace / 2 == HomePartnerFace / 2)
+            {
+                return -1;
+            }
+            const int32_t HomeOffset = GetHandedness(HomeFace, HomePartnerFace) * Chirality;
+            int32_t Coords[3] = {};
+            Coords[HomeFace / 2] = GetEnd(HomeFace);
+            Coords[HomePartnerFace / 2] = GetEnd(HomePartnerFace);
+            Coords[3 - HomeFace / 2 - HomePartnerFace / 2] = (HomeOffset + N - 1) / 2;
+            return Encode(HomeFace, Coords);
+        }
+
+        int32_t GetCornerHome(int32_t CornerIndex) const
+        {
+            const int32_t Coords[3] = { (CornerIndex & 1) ? N - 1 : 0, (CornerIndex & 2) ? N - 1 : 0, (CornerIndex & 4) ? N - 1 : 0 };
+            int32_t Home = 0;
+            for (int32_t Axis = 0; Axis < 3; Axis++)
+            {
+                const int32_t Face = Axis * 2 + (Coords[Axis] == 0 ? 1 : 0);
+                const int32_t ColourFace = ColourFaces[GetColour(Encode(Face, Coords))];
+                Home |= (ColourFace % 2 == 0) ? (1 << (ColourFace / 2)) : 0;
+            }
+            return Home;
+        }
+
+        // 中心块三循环不改变任何棱块和角块的置换，所以奇偶要在一开始就调好
+        void FixParity()
+        {
+            if (N % 2 == 0)
+            {
+                std::vector<int32_t> Corners(8);
+                for (int32_t Corner = 0; Corner < 8; Corner++)
+                {
+                    Corners[Corner] = GetCornerHome(Corner);
+                }
+                if (GetPermutationParity(Corners) != 0)
+                {
+                    Emit(FLayerTurn{ 0, 0, 1 });
+                }
+            }
+
+            std::vector<int32_t> Slots;
+            std::vector<int32_t> Targets;
+            for (int32_t Layer = 1; Layer < N - 1 - Layer; Layer++)
+            {
+                GetWingSlots(Layer, Slots);
+                Targets.assign(Slots.size(), 0);
+                for (size_t Index = 0; Index < Slots.size(); Index++)
+                {
+                    int32_t Home = GetWingHome(Slots[Index]);
+                    Home = (Home / FaceSize < GetWingPartner(Home) / FaceSize) ? Home : GetWingPartner(Home);
+                    for (size_t Target = 0; Target < Slots.size(); Target++)
+                    {
+                        Targets[Index] = (Slots[Target] == Home) ? static_cast<int32_t>(Target) : Targets[Index];
+                    }
+                }
+                if (GetPermutationParity(Targets) != 0)
+                {
+                    Emit(FLayerTurn{ 0, Layer, 1 });
+                }
+            }
+        }
+
+        // ---- 三循环 ----
+
+        // A 动到的所有贴纸里，只有 Piece 中的贴纸同时被 B 动到时，[A, B] 就是一个纯三循环
+        bool IsPureCycle(const FCommutator& Commutator, int32_t Target, int32_t Partner) const
+        {
+            const int32_t Axis = Commutator.A.AxisIndex;
+            int32_t NumShared = 0;
+            for (int32_t Face = 0; Face < FFaceletCube::NumFaces; Face++)
+            {
+                if (Face / 2 == Axis)
+                {
+                    continue;
+                }
+                for (int32_t Along = 0; Along < N; Along++)
+                {
+                    int32_t Coords[3] = {};
+                    Coords[Face / 2] = GetEnd(Face);
+                    Coords[Axis] = Commutator.A.Layer;
+                    Coords[3 - Face / 2 - Axis] = Along;
+                    const int32_t Position = Encode(Face, Coords);
+                    const int32_t Moved = MovePosition(Position, Commutator.Y);
+                    if (MovePosition(Moved, Commutator.Z) == Moved)
+                    {
+                        continue;
+                    }
+                    if (Position != Target && Position != Partner)
+                    {
+                        return false;
+                    }
+                    NumShared++;
+                }
+            }
+            return NumShared == (Partner == Target ? 1 : 2);
+        }
+
+        // 在候选换位子里找一组准备步骤 S：来源块经 S 到达换位子送往目标的位置，目标原来的块换到一个未还原的位置
+        // 准备步骤不动目标块，所以 S·K·S' 只循环 目标 <- 来源 <- 空位 <- 目标 三块
+        template <typename FIsSource>
+        bool CycleInto(int32_t Target, int32_t Partner, FIsSource IsSource)
+        {
+            FLayerTurn Moves[8];
+            for (int32_t MaxDepth = 0; MaxDepth <= MaxSetupMoves; MaxDepth++)
+            {
+                for (const FCommutator& Commutator : Candidates)
+                {
+                    GetCommutatorMoves(Commutator, Moves);
+                    int32_t Into = Target;
+                    for (int32_t i = 7; i >= 0; i--)
+                    {
+                        Into = MovePosition(Into, Inverse(Moves[i]));
+                    }
+                    int32_t OutOf = Target;
+                    for (int32_t i = 0; i < 8; i++)
+                    {
+                        OutOf = MovePosition(OutOf, Moves[i]);
+                    }
+
+                    const int32_t Found = FindSetup(Target, Partner, Into, OutOf, MaxDepth, IsSource);
+                    if (Found < 0)
+                    {
+                        continue;
+                    }
+
+                    // 搜索得到的是 S'，先倒序取反输出 S
+                    std::vector<FLayerTurn> Setup;
+                    for (int32_t Node = Found; SetupNodes[Node].Parent >= 0; Node = SetupNodes[Node].Parent)
+                    {
+                        Setup.push_back(SetupNodes[Node].Move);
+                    }
+                    for (const FLayerTurn& Move : Setup)
+                    {
+                        Emit(Inverse(Move));
+                    }
+                    for (const FLayerTurn& Move : Moves)
+                    {
+                        Emit(Move);
+                    }
+                    for (auto It = Setup.rbegin(); It != Setup.rend(); ++It)
+                    {
+                        Emit(*It);
+                    }
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // 广度优先：同时跟踪“送往目标的位置”和“目标块被送去的位置”在 S' 下的去向，只用会动到二者之一、且不动目标的转动
+        template <typename FIsSource>
+        int32_t FindSetup(int32_t Target, int32_t Partner, int32_t Into, int32_t OutOf, int32_t MaxDepth, FIsSource& IsSource)
+        {
+            const int64_t NumPositions = static_cast<int64_t>(FFaceletCube::NumFaces) * FaceSize;
+            SetupNodes.clear();
+            SetupVisited.clear();
+            SetupNodes.push_back(FSetupNode{ Into, OutOf, -1, FLayerTurn{}, 0 });
+            SetupVisited.insert(Into * NumPositions + OutOf);
+
+            for (size_t Head = 0; Head < SetupNodes.size(); Head++)
+            {
+                const FSetupNode Node = SetupNodes[Head];
+                if (IsSource(Node.Source) && Node.Free != Target && Node.Free != Partner && !Solved[Node.Free])
+                {
+                    CountNodes(Head + 1);
+                    return static_cast<int32_t>(Head);
+                }
+                if (Node.Depth == MaxDepth)
+                {
+                    continue;
+                }
+
+                for (int32_t Tracked : { Node.Source, Node.Free })
+                {
+                    const FSticker Sticker = Decode(Tracked);
+                    for (int32_t Axis = 0; Axis < 3; Axis++)
+                    {
+                        for (int32_t Turns = 1; Turns <= 3; Turns++)
+                        {
+                            const FLayerTurn Move{ Axis, Sticker.Coords[Axis], Turns == 3 ? -1 : Turns };
+                            if (IsMovedBy(Target, Move))
+                            {
+                                continue;
+                            }
+                            const int32_t Source = MovePosition(Node.Source, Move);
+                            const int32_t Free = MovePosition(Node.Free, Move);
+                            if (SetupVisited.insert(Source * NumPositions + Free).second)
+                            {
+                                SetupNodes.push_back(FSetupNode{ Source, Free, static_cast<int32_t>(Head), Move, Node.Depth + 1 });
+                            }
+                        }
+                    }
+                }
+            }
+            CountNodes(SetupNodes.size());
+            return -1;
+        }
+
+        void CountNodes(size_t Count)
+        {
+            if (SearchControl != nullptr)
+            {
+                SearchControl->AddNodes(static_cast<int64_t>(Count));
+            }
+        }
+
+        // ---- 2：中心 ----
+
+        void BuildCenterCandidates(int32_t Target)
+        {
+            Candidates.clear();
+            const FSticker Sticker = Decode(Target);
+            const int32_t Axis = Sticker.Face / 2;
+            for (int32_t SliceAxis : { (Axis + 1) % 3, (Axis + 2) % 3 })
+            {
+                for (int32_t FaceTurn : { 1, -1 })
+                {
+                    const FLayerTurn Y{ Axis, GetEnd(Sticker.Face), FaceTurn };
+                    const int32_t Layer = Decode(MovePosition(Target, Y)).Coords[SliceAxis];
+                    for (int32_t ATurns : { 1, -1, 2 })
+                    {
+                        for (int32_t ZTurns : { 1, -1, 2 })
+                        {
+                            const FCommutator Commutator{ FLayerTurn{ SliceAxis, Sticker.Coords[SliceAxis], ATurns }, Y, FLayerTurn{ SliceAxis, Layer, ZTurns } };
+                            if (IsPureCycle(Commutator, Target, Target))
+                            {
+                                Candidates.push_back(Commutator);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        bool SolveCenters()
+        {
+            // 最后一个面在前五个面完成后自然还原
+            static constexpr int32_t FaceOrder[5] = { 4, 5, 0, 1, 2 };
+            for (int32_t Face : FaceOrder)
+            {
+                const uint8_t Colour = FaceColours[Face];
+                for (int32_t V = 1; V < N - 1; V++)
+                {
+                    for (int32_t U = 1; U < N - 1; U++)
+                    {
+                        const int32_t Target = Face * FaceSize + U + V * N;
+                        if (GetColour(Target) != Colour)
+                        {
+                            if (IsCancelled())
+                            {
+                                return false;
+                            }
+                            BuildCenterCandidates(Target);
+                            if (!CycleInto(Target, Target, [this, Colour](int32_t Position) { return GetColour(Position) == Colour && !Solved[Position]; }))
+                            {
+                                return false;
+                            }
+                        }
+                        Solved[Target] = 1;
+                    }
+                }
+            }
+            return true;
+        }
+
+        // ---- 4：棱 ----
+
+        void BuildWingCandidates(int32_t Target)
+        {
+            Candidates.clear();
+            const FSticker Sticker = Decode(Target);
+            const int32_t PartnerFace = GetWingPartner(Target) / FaceSize;
+            const int32_t EdgeAxis = 3 - Sticker.Face / 2 - PartnerFace / 2;
+            for (int32_t Face : { Sticker.Face, PartnerFace })
+            {
+                for (int32_t FaceTurn : { 1, -1 })
+                {
+                    for (int32_t OuterLayer : { 0, N - 1 })
+                    {
+                        for (int32_t ATurns : { 1, -1, 2 })
+                        {
+                            for (int32_t ZTurns : { 1, -1, 2 })
+                            {
+                                const FCommutator Commutator{ FLayerTurn{ EdgeAxis, Sticker.Coords[EdgeAxis], ATurns },
+                                    FLayerTurn{ Face / 2, GetEnd(Face), FaceTurn }, FLayerTurn{ EdgeAxis, OuterLayer, ZTurns } };
+                                if (IsPureCycle(Commutator, Target, GetWingPartner(Target)))
+                                {
+                                    Candidates.push_back(Commutator);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        bool SolveWings()
+        {
+            std::vector<int32_t> Slots;
+            for (int32_t Layer = 1; Layer < N - 1 - Layer; Layer++)
+            {
+                GetWingSlots(Layer, Slots);
+                for (int32_t Target : Slots)
+                {
+                    const int32_t Partner = GetWingPartner(Target);
+                    if (GetWingHome(Target) != Target)
+                    {
+                        if (IsCancelled())
+                        {
+                            return false;
+                        }
+
+                        // 棱块各不相同，来源就是唯一一块归属于这里的棱块
+                        int32_t Source = -1;
+                        for (int32_t Slot : Slots)
+                        {
+                            Source = (GetWingHome(Slot) == Target) ? Slot : Source;
+                            Source = (GetWingHome(GetWingPartner(Slot)) == Target) ? GetWingPartner(Slot) : Source;
+                        }
+                        BuildWingCandidates(Target);
+                        if (Source < 0 || !CycleInto(Target, Partner, [Source](int32_t Position) { return Position == Source; }))
+                        {
+                            return false;
+                        }
+                    }
+                    Solved[Target] = 1;
+                    Solved[Partner] = 1;
+                }
+            }
+            return true;
+        }
+
+        // ---- 3：三阶阶段 ----
+
+        bool SolveThreeByThree()
+        {
+            // 3 阶坐标 0/1/2 对应大魔方的 0/中间/N-1；偶数阶没有中棱，棱一律当作已还原，只解角块
+            auto GetFace = [this](int32_t Face, int32_t U, int32_t V)
+            {
+                if (N % 2 == 0 && (U == 1 || V == 1))
+                {
+                    return Face;
+                }
+                const int32_t Map[3] = { 0, N / 2, N - 1 };
+                return ColourFaces[Cube.GetSticker(Face, Map[U], Map[V])];
+            };
+
+            FTwoPhaseSolver::FCubies Cubies;
+            std::vector<FLayerTurn> Moves;
+            if (!ThreeByThree.PrepareFromFaces(GetFace, Cubies) || !ThreeByThree.SolveCubies(Cubies, FinalPhaseTargetLength, Moves, SearchControl))
+            {
+                return false;
+            }
+            for (const FLayerTurn& Move : Moves)
+            {
+                Emit(FLayerTurn{ Move.AxisIndex, Move.Layer == 0 ? 0 : N - 1, Move.QuarterTurns });
+            }
+            return true;
+        }
+    };
+}
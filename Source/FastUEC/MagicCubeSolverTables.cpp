@@ -0,0 +1,95 @@
+#include "MagicCubeSolverTables.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+    // 缓存文件头：魔数 + 版本 + 数据长度，数据紧随其后
+    struct FTableFileHeader
+    {
+        uint32 Magic = 0;
+        uint32 Version = 0;
+        int64 Size = 0;
+    };
+
+    static constexpr uint32 TableFileMagic = 0x4255434D; // "MCUB"
+
+    // 映射或生成出来的表，进程退出前一直保留
+    struct FLoadedTable
+    {
+        TUniquePtr<IMappedFileHandle> Handle;
+        TUniquePtr<IMappedFileRegion> Region;
+        TArray<uint8> Owned;
+    };
+
+    FCriticalSection LoadedTablesLock;
+    TArray<TUniquePtr<FLoadedTable>> LoadedTables;
+}
+
+const MagicCube::FPocketCubeSolver& FMagicCubeSolverTables::GetPocketCubeSolver()
+{
+    static const MagicCube::FPocketCubeSolver* Solver = []()
+    {
+        MagicCube::FPocketCubeSolver* NewSolver = new MagicCube::FPocketCubeSolver();
+        NewSolver->SetDistanceTable(MapOrBuildTable(TEXT("PocketCubeDistance.bin"), 1, MagicCube::FPocketCubeSolver::DistanceTableBytes,
+            [NewSolver](uint8* Table) { NewSolver->BuildDistanceTable(Table); }));
+        return NewSolver;
+    }();
+    return *Solver;
+}
+
+const MagicCube::FTwoPhaseSolver& FMagicCubeSolverTables::GetTwoPhaseSolver()
+{
+    static const MagicCube::FTwoPhaseSolver* Solver = []()
+    {
+        MagicCube::FTwoPhaseSolver* NewSolver = new MagicCube::FTwoPhaseSolver();
+        NewSolver->SetPruningTables(MapOrBuildTable(TEXT("TwoPhasePruning.bin"), 1, MagicCube::FTwoPhaseSolver::PruningTableBytes,
+            [NewSolver](uint8* Tables) { NewSolver->BuildPruningTables(Tables); }));
+        return NewSolver;
+    }();
+    return *Solver;
+}
+
+const uint8* FMagicCubeSolverTables::MapOrBuildTable(const TCHAR* Name, uint32 Version, int64 Size, TFunctionRef<void(uint8*)> Build)
+{
+    FScopeLock Lock(&LoadedTablesLock);
+
+    const FString Path = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("MagicCube"), Name);
+    const int64 FileSize = sizeof(FTableFileHeader) + Size;
+    FLoadedTable& Table = *LoadedTables.Add_GetRef(MakeUnique<FLoadedTable>());
+
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    if (PlatformFile.FileSize(*Path) == FileSize)
+    {
+        IPlatformFile::FOpenMappedResult Result = PlatformFile.OpenMappedEx(*Path);
+        if (Result.HasValue())
+        {
+            Table.Handle = Result.StealValue();
+            Table.Region.Reset(Table.Handle->MapRegion(0, FileSize));
+            if (Table.Region.IsValid())
+            {
+                const FTableFileHeader* Header = reinterpret_cast<const FTableFileHeader*>(Table.Region->GetMappedPtr());
+                if (Header->Magic == TableFileMagic && Header->Version == Version && Header->Size == Size)
+                {
+                    return Table.Region->GetMappedPtr() + sizeof(FTableFileHeader);
+                }
+            }
+            Table.Region.Reset();
+            Table.Handle.Reset();
+        }
+    }
+
+    // 生成后写盘；写盘失败也不影响本次使用
+    Table.Owned.SetNumUninitialized(FileSize);
+    FTableFileHeader Header;
+    Header.Magic = TableFileMagic;
+    Header.Version = Version;
+    Header.Size = Size;
+    FMemory::Memcpy(Table.Owned.GetData(), &Header, sizeof(Header));
+    Build(Table.Owned.GetData() + sizeof(FTableFileHeader));
+    FFileHelper::SaveArrayToFile(Table.Owned, *Path);
+    return Table.Owned.GetData() + sizeof(FTableFileHeader);
+}
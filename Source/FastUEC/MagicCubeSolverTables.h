@@ -0,0 +1,23 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MagicCubePocketSolver.h"
+#include "MagicCubeTwoPhaseSolver.h"
+
+// Teng：求解器查找表的加载与缓存
+// 表第一次用到时生成并写到 Saved/MagicCube/ 下，之后的启动直接内存映射，不再重新生成
+// 返回的求解器是只读的，可以在任意线程上并发使用
+class FASTUEC_API FMagicCubeSolverTables
+{
+public:
+    // 2 阶最优解求解器；首次调用会阻塞到表加载或生成完毕
+    static const MagicCube::FPocketCubeSolver& GetPocketCubeSolver();
+
+    // 3 阶两阶段求解器；转动表在构造时生成，剪枝表走磁盘缓存
+    static const MagicCube::FTwoPhaseSolver& GetTwoPhaseSolver();
+
+private:
+    // 映射 Saved/MagicCube/<Name>，文件不存在或版本、大小不符时调用 Build 生成并写盘
+    // 返回的内存在进程生命周期内有效
+    static const uint8* MapOrBuildTable(const TCHAR* Name, uint32 Version, int64 Size, TFunctionRef<void(uint8*)> Build);
+};
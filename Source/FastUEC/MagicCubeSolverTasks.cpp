@@ -0,0 +1,90 @@
+#include "MagicCubeSolverTasks.h"
+#include "MagicCubeSolverTables.h"
+#include "Misc/ScopeLock.h"
+#include "Tasks/Task.h"
+
+bool FMagicCubeSolverTasks::Solve(const MagicCube::FCubeState& State, int32 TargetLength, std::vector<MagicCube::FLayerTurn>& OutMoves, MagicCube::FSearchControl* Control)
+{
+    switch (State.GetFixedOrder())
+    {
+    case 2: return FMagicCubeSolverTables::GetPocketCubeSolver().Solve(State, OutMoves, Control);
+    case 3: return SolveTwoPhase(State, TargetLength, OutMoves, Control);
+    default: break;
+    }
+    OutMoves.clear();
+    return false;
+}
+
+bool FMagicCubeSolverTasks::SolveTwoPhase(const MagicCube::FCubeState& State, int32 TargetLength, std::vector<MagicCube::FLayerTurn>& OutMoves, MagicCube::FSearchControl* Control)
+{
+    using MagicCube::FTwoPhaseSolver;
+
+    OutMoves.clear();
+    const FTwoPhaseSolver& Solver = FMagicCubeSolverTables::GetTwoPhaseSolver();
+    FTwoPhaseSolver::FCubies Start;
+    if (!Solver.Prepare(State, Start))
+    {
+        return false;
+    }
+
+    // Stop 也会因为取消而置位，所以是否找到解单独记在 bFound 里
+    FCriticalSection ResultLock;
+    std::vector<int32_t> Result;
+    bool bFound = false;
+    const int32 FirstTarget = FMath::Clamp(TargetLength, 0, FTwoPhaseSolver::MaxSolutionLength);
+    for (int32 MaxTotal = FirstTarget; MaxTotal <= FTwoPhaseSolver::MaxSolutionLength; MaxTotal += 2)
+    {
+        std::atomic<bool> Stop(false);
+        for (int32 Depth = Solver.GetPhase1Estimate(Start); Depth <= FTwoPhaseSolver::MaxPhase1Depth && Depth <= MaxTotal; Depth++)
+        {
+            if (Control != nullptr)
+            {
+                if (Control->IsCancelled())
+                {
+                    return false;
+                }
+                Control->SetDepth(Depth);
+            }
+
+            if (Depth == 0)
+            {
+                bFound = Solver.SearchBranch(Start, 0, 0, MaxTotal, Stop, Result, Control);
+            }
+            else
+            {
+                // 同一深度的分支全部结束后才加深，保证先返回第一阶段更短的解
+                TArray<UE::Tasks::FTask, TInlineAllocator<FTwoPhaseSolver::NumMoves>> Branches;
+                for (int32 RootMove = 0; RootMove < FTwoPhaseSolver::NumMoves; RootMove++)
+                {
+                    Branches.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION, [&Solver, &Start, &Stop, &ResultLock, &Result, &bFound, Control, RootMove, Depth, MaxTotal]()
+                    {
+                        std::vector<int32_t> Path;
+                        if (Solver.SearchBranch(Start, RootMove, Depth, MaxTotal, Stop, Path, Control))
+                        {
+                            FScopeLock Lock(&ResultLock);
+                            if (!bFound)
+                            {
+                                Result = MoveTemp(Path);
+                                bFound = true;
+                            }
+                        }
+                    }));
+                }
+                UE::Tasks::Wait(Branches);
+            }
+
+            if (bFound)
+            {
+                Solver.ToLayerTurns(Start, Result, OutMoves);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool FMagicCubeSolverTasks::SolveReduction(const MagicCube::FFaceletCube& Start, const MagicCube::FReductionSolver::FEmitMove& Emit, MagicCube::FSearchControl* Control)
+{
+    MagicCube::FReductionSolver Solver(FMagicCubeSolverTables::GetTwoPhaseSolver());
+    return Solver.Solve(Start, Emit, Control);
+}
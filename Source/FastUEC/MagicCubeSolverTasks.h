@@ -0,0 +1,24 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MagicCubeCore.h"
+#include "MagicCubeReductionSolver.h"
+
+#include <vector>
+
+// Teng：在任务系统上运行求解器
+// 这里的函数都会阻塞到出结果，应在工作线程上调用；State 是调用方持有的快照，求解期间不能被修改
+// Control 可选：取消后尽快返回 false，进度（搜索节点数、当前深度）持续写入
+class FASTUEC_API FMagicCubeSolverTasks
+{
+public:
+    // 按尺寸选择求解器：2x2x2 为最优解，3x3x3 为两阶段解；其他尺寸返回 false
+    static bool Solve(const MagicCube::FCubeState& State, int32 TargetLength, std::vector<MagicCube::FLayerTurn>& OutMoves, MagicCube::FSearchControl* Control = nullptr);
+
+    // 两阶段求解：第一阶段按首步拆成 18 个分支交给 UE::Tasks 的工作窃取调度并行搜索
+    // 任一分支找到总长不超过 TargetLength 的解就通知其余分支停止；整个深度范围内都没有时放宽目标重试
+    static bool SolveTwoPhase(const MagicCube::FCubeState& State, int32 TargetLength, std::vector<MagicCube::FLayerTurn>& OutMoves, MagicCube::FSearchControl* Control = nullptr);
+
+    // 4 阶及以上的降阶法求解：每确定一步就在当前线程上调用一次 Emit，不等整个解算完
+    static bool SolveReduction(const MagicCube::FFaceletCube& Start, const MagicCube::FReductionSolver::FEmitMove& Emit, MagicCube::FSearchControl* Control = nullptr);
+};
@@ -0,0 +1,824 @@
+#pragma once
+
+// Teng：3 阶魔方的两阶段（Kociemba）求解器（纯逻辑，不依赖引擎）
+// 先用整体转动把中心块转回初始位置（核心方块的朝向就是中心的整体朝向），于是只剩 6 个面、18 种转动
+// Z 轴作为 U/D 轴：
+//   第一阶段：角块朝向(2187) × 棱块朝向(2048) × 中层棱位置(495)，目标是进入 <U, D, R2, L2, F2, B2> 子群
+//   第二阶段：角块排列(40320) × 上下层棱块排列(40320) × 中层棱排列(24)，只用子群内的 10 种转动
+// 剪枝表是两两坐标组合上的精确距离（每项 4 位），由外部提供内存（磁盘缓存的内存映射）
+// 第一阶段按首步拆成互不相交的分支，SearchBranch 可以在多个线程上同时调用，Stop 置位后各分支尽快返回
+// 传入 FSearchControl 时，搜索节点数定期累加上去，取消请求会转成 Stop
+
+#include "MagicCubeCore.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MagicCube
+{
+    class FTwoPhaseSolver
+    {
+    public:
+        static constexpr int32_t NumCorners = 8;
+        static constexpr int32_t NumEdges = 12;
+        static constexpr int32_t NumMoves = 18;       // (轴 * 2 + 侧) * 3 + (转数 - 1)，侧 0 为第 0 层、1 为第 2 层
+        static constexpr int32_t NumPhase2Moves = 10;
+        static constexpr int32_t NumTwists = 2187;
+        static constexpr int32_t NumFlips = 2048;
+        static constexpr int32_t NumSlices = 495;
+        static constexpr int32_t SolvedSlice = 494;   // 4 条中层棱都在槽位 8..11
+        static constexpr int32_t NumCornerPermutations = 40320;
+        static constexpr int32_t NumEdgePermutations = 40320;
+        static constexpr int32_t NumSlicePermutations = 24;
+        static constexpr int32_t MaxPhase1Depth = 12;
+        static constexpr int32_t MaxPhase2Depth = 18;
+        static constexpr int32_t MaxSolutionLength = MaxPhase1Depth + MaxPhase2Depth;
+
+        static constexpr int32_t TwistSliceEntries = NumTwists * NumSlices;
+        static constexpr int32_t FlipSliceEntries = NumFlips * NumSlices;
+        static constexpr int32_t CornerSliceEntries = NumCornerPermutations * NumSlicePermutations;
+        static constexpr int32_t EdgeSliceEntries = NumEdgePermutations * NumSlicePermutations;
+        static constexpr int32_t PruningTableBytes =
+            (TwistSliceEntries + 1) / 2 + (FlipSliceEntries + 1) / 2 + (CornerSliceEntries + 1) / 2 + (EdgeSliceEntries + 1) / 2;
+
+        // 求解器坐标系下的魔方：每个角/棱槽位上的方块和朝向，以及换回原坐标系所需的整体朝向
+        struct FCubies
+        {
+            uint8_t Corners[NumCorners] = {};
+            uint8_t Twists[NumCorners] = {};
+            uint8_t Edges[NumEdges] = {};
+            uint8_t Flips[NumEdges] = {};
+            uint8_t FrameOrientation = 0;
+        };
+
+        FTwoPhaseSolver()
+        {
+            BuildGeometry();
+            BuildMoveTables();
+        }
+
+        void BuildPruningTables(uint8_t* OutTables) const
+        {
+            uint8_t* TwistSlice = OutTables;
+            uint8_t* FlipSlice = TwistSlice + (TwistSliceEntries + 1) / 2;
+            uint8_t* CornerSlice = FlipSlice + (FlipSliceEntries + 1) / 2;
+            uint8_t* EdgeSlice = CornerSlice + (CornerSliceEntries + 1) / 2;
+            BuildPruningTable(TwistSlice, NumTwists, TwistMoves.data(), NumSlices, SolvedSlice, SliceMoves.data(), NumMoves);
+            BuildPruningTable(FlipSlice, NumFlips, FlipMoves.data(), NumSlices, SolvedSlice, SliceMoves.data(), NumMoves);
+            BuildPruningTable(CornerSlice, NumCornerPermutations, CornerPermutationMoves.data(), NumSlicePermutations, 0, SlicePermutationMoves.data(), NumPhase2Moves);
+            BuildPruningTable(EdgeSlice, NumEdgePermutations, EdgePermutationMoves.data(), NumSlicePermutations, 0, SlicePermutationMoves.data(), NumPhase2Moves);
+        }
+
+        // 剪枝表的内存需在求解器的整个使用期内有效
+        void SetPruningTables(const uint8_t* InTables)
+        {
+            TwistSlicePruning = InTables;
+            FlipSlicePruning = TwistSlicePruning + (TwistSliceEntries + 1) / 2;
+            CornerSlicePruning = FlipSlicePruning + (FlipSliceEntries + 1) / 2;
+            EdgeSlicePruning = CornerSlicePruning + (CornerSliceEntries + 1) / 2;
+        }
+
+        bool IsReady() const { return TwistSlicePruning != nullptr; }
+
+        // 从离散状态取出求解器坐标；State 必须是没有空槽的 3x3x3
+        bool Prepare(const FCubeState& State, FCubies& Out) const
+        {
+            if (State.GetFixedOrder() != 3)
+            {
+                return false;
+            }
+
+            // 整体转动 W 让核心方块回到初始朝向，中心块随之全部归位
+            const uint8_t CoreOrientation = State.GetCubieOrientation(CoreSlot);
+            uint8_t Normalize = 0;
+            while (OrientationTable.Compose[Normalize][CoreOrientation] != 0)
+            {
+                Normalize++;
+            }
+            Out.FrameOrientation = CoreOrientation;
+
+            for (int32_t Cubie = 0; Cubie < State.GetNumCubies(); Cubie++)
+            {
+                const int32_t HomeSlot = State.GetCubieHomeSlot(Cubie);
+                const int32_t Slot = State.RotateSlot(State.GetCubieSlot(Cubie), Normalize);
+                const uint8_t Orientation = OrientationTable.Compose[Normalize][State.GetCubieOrientation(Cubie)];
+                if (SlotToCorner[HomeSlot] >= 0)
+                {
+                    const int32_t Position = SlotToCorner[Slot];
+                    const int32_t Face = RotateFace(CornerFaces[SlotToCorner[HomeSlot]][0], OrientationTable.Matrices[Orientation]);
+                    Out.Corners[Position] = static_cast<uint8_t>(SlotToCorner[HomeSlot]);
+                    Out.Twists[Position] = static_cast<uint8_t>(Face == CornerFaces[Position][0] ? 0 : (Face == CornerFaces[Position][1] ? 1 : 2));
+                }
+                else if (SlotToEdge[HomeSlot] >= 0)
+                {
+                    const int32_t Position = SlotToEdge[Slot];
+                    const int32_t Face = RotateFace(EdgeFaces[SlotToEdge[HomeSlot]][0], OrientationTable.Matrices[Orientation]);
+                    Out.Edges[Position] = static_cast<uint8_t>(SlotToEdge[HomeSlot]);
+                    Out.Flips[Position] = static_cast<uint8_t>(Face == EdgeFaces[Position][0] ? 0 : 1);
+                }
+            }
+            return true;
+        }
+
+        int32_t GetPhase1Estimate(const FCubies& Cubies) const
+        {
+            return Phase1Estimate(EncodeTwist(Cubies.Twists), EncodeFlip(Cubies.Flips), EncodeSlice(Cubies.Edges));
+        }
+
+        // 搜索第一阶段恰好 Phase1Depth 步、且首步为 RootMove 的全部分支（Phase1Depth 为 0 时 RootMove 被忽略）
+        // 每找到一个第一阶段解就尝试在总长 MaxTotal 内完成第二阶段；成功时写出完整路径（转动下标）并置位 Stop
+        bool SearchBranch(const FCubies& Start, int32_t RootMove, int32_t Phase1Depth, int32_t MaxTotal, std::atomic<bool>& Stop, std::vector<int32_t>& OutPath, FSearchControl* Control = nullptr) const
+        {
+            FSearch Search{ Start, MaxTotal, Stop, Control, {} };
+            const int32_t Twist = EncodeTwist(Start.Twists);
+            const int32_t Flip = EncodeFlip(Start.Flips);
+            const int32_t Slice = EncodeSlice(Start.Edges);
+
+            bool bFound = false;
+            if (Phase1Depth == 0)
+            {
+                bFound = Phase1Estimate(Twist, Flip, Slice) == 0 && SearchPhase2(Search, 0);
+            }
+            else
+            {
+                Search.Path[0] = RootMove;
+                bFound = SearchPhase1(Search, TwistMoves[Twist * NumMoves + RootMove], FlipMoves[Flip * NumMoves + RootMove],
+                    SliceMoves[Slice * NumMoves + RootMove], 1, Phase1Depth, RootMove / 3);
+            }
+
+            FlushNodes(Search);
+            if (bFound)
+            {
+                Stop.store(true, std::memory_order_relaxed);
+                OutPath.assign(Search.Path, Search.Path + Search.Length);
+            }
+            return bFound;
+        }
+
+        // 把转动下标换回 State 的坐标系
+        void ToLayerTurns(const FCubies& Start, const std::vector<int32_t>& Path, std::vector<FLayerTurn>& OutMoves) const
+        {
+            OutMoves.clear();
+            const int32_t (&M)[3][3] = OrientationTable.Matrices[Start.FrameOrientation];
+            for (int32_t Move : Path)
+            {
+                const int32_t Axis = Move / 6;
+                const bool bPositiveSide = (Move / 3) % 2 == 1;
+                const int32_t Turns = Move % 3 + 1;
+                const int32_t SignedTurns = Turns == 3 ? -1 : Turns;
+                for (int32_t TargetAxis = 0; TargetAxis < 3; TargetAxis++)
+                {
+                    const int32_t Sign = M[TargetAxis][Axis];
+                    if (Sign != 0)
+                    {
+                        const bool bTargetPositive = bPositiveSide == (Sign > 0);
+                        OutMoves.push_back(FLayerTurn{ TargetAxis, bTargetPositive ? 2 : 0, (Sign > 0 || SignedTurns == 2) ? SignedTurns : -SignedTurns });
+                    }
+                }
+            }
+        }
+
+        // 从 3 阶贴纸取坐标，中心视为已在初始位置；GetFace(面, u, v) 返回该贴纸的颜色在还原状态下所在的面
+        // 大阶魔方降阶后的最后一步用它读取角块和棱块
+        template <typename FGetFace>
+        bool PrepareFromFaces(FGetFace GetFace, FCubies& Out) const
+        {
+            Out = FCubies();
+            for (int32_t Position = 0; Position < NumCorners; Position++)
+            {
+                int32_t Faces[3] = {};
+                int32_t HomeCoords[3] = { 1, 1, 1 };
+                for (int32_t i = 0; i < 3; i++)
+                {
+                    Faces[i] = GetStickerFace(CornerSlots[Position], CornerFaces[Position][i], GetFace);
+                    HomeCoords[Faces[i] / 2] = (Faces[i] % 2 == 0) ? 2 : 0;
+                }
+                const int32_t Home = SlotToCorner[HomeCoords[0] + HomeCoords[1] * 3 + HomeCoords[2] * 9];
+                if (Home < 0)
+                {
+                    return false;
+                }
+                Out.Corners[Position] = static_cast<uint8_t>(Home);
+                Out.Twists[Position] = static_cast<uint8_t>(Faces[0] / 2 == 2 ? 0 : (Faces[1] / 2 == 2 ? 1 : 2));
+            }
+            for (int32_t Position = 0; Position < NumEdges; Position++)
+            {
+                int32_t Faces[2] = {};
+                int32_t HomeCoords[3] = { 1, 1, 1 };
+                for (int32_t i = 0; i < 2; i++)
+                {
+                    Faces[i] = GetStickerFace(EdgeSlots[Position], EdgeFaces[Position][i], GetFace);
+                    HomeCoords[Faces[i] / 2] = (Faces[i] % 2 == 0) ? 2 : 0;
+                }
+                const int32_t Home = Faces[0] / 2 == Faces[1] / 2 ? -1 : SlotToEdge[HomeCoords[0] + HomeCoords[1] * 3 + HomeCoords[2] * 9];
+                if (Home < 0)
+                {
+                    return false;
+                }
+                Out.Edges[Position] = static_cast<uint8_t>(Home);
+                Out.Flips[Position] = static_cast<uint8_t>(Faces[0] == EdgeFaces[Home][0] ? 0 : 1);
+            }
+            return true;
+        }
+
+        // 单线程求解：按第一阶段深度递增，找到总长不超过 TargetLength 的解即返回，找不到就放宽目标再试
+        bool Solve(const FCubeState& State, int32_t TargetLength, std::vector<FLayerTurn>& OutMoves, FSearchControl* Control = nullptr) const
+        {
+            OutMoves.clear();
+            FCubies Start;
+            return IsReady() && Prepare(State, Start) && SolveCubies(Start, TargetLength, OutMoves, Control);
+        }
+
+        bool SolveCubies(const FCubies& Start, int32_t TargetLength, std::vector<FLayerTurn>& OutMoves, FSearchControl* Control = nullptr) const
+        {
+            OutMoves.clear();
+            std::vector<int32_t> Path;
+            const int32_t FirstTarget = TargetLength < MaxSolutionLength ? TargetLength : MaxSolutionLength;
+            for (int32_t MaxTotal = FirstTarget; MaxTotal <= MaxSolutionLength; MaxTotal += 2)
+            {
+                std::atomic<bool> Stop(false);
+                for (int32_t Depth = GetPhase1Estimate(Start); Depth <= MaxPhase1Depth && Depth <= MaxTotal; Depth++)
+                {
+                    if (Control != nullptr)
+                    {
+                        Control->SetDepth(Depth);
+                    }
+                    for (int32_t RootMove = 0; RootMove < (Depth == 0 ? 1 : NumMoves); RootMove++)
+                    {
+                        if (SearchBranch(Start, RootMove, Depth, MaxTotal, Stop, Path, Control))
+                        {
+                            ToLayerTurns(Start, Path, OutMoves);
+                            return true;
+                        }
+                        if (Control != nullptr && Control->IsCancelled())
+                        {
+                            return false;
+                        }
+                    }
+                }
+            }
+            return false;
+        }
+
+    private:
+        static constexpr int32_t CoreSlot = 13;
+
+        // 几何：角/棱槽位列表，以及每个槽位的面（第一个是参考面）
+        int32_t CornerSlots[NumCorners] = {};
+        int32_t EdgeSlots[NumEdges] = {};
+        int32_t SlotToCorner[27] = {};
+        int32_t SlotToEdge[27] = {};
+        int32_t CornerFaces[NumCorners][3] = {};
+        int32_t EdgeFaces[NumEdges][2] = {};
+        int32_t Phase2Moves[NumPhase2Moves] = {};
+
+        // 每种转动对角/棱的作用：新位置，以及朝向的变化（旧朝向 -> 新朝向）
+        int32_t CornerTargets[NumMoves][NumCorners] = {};
+        int32_t TwistTargets[NumMoves][NumCorners][3] = {};
+        int32_t EdgeTargets[NumMoves][NumEdges] = {};
+        int32_t FlipTargets[NumMoves][NumEdges][2] = {};
+
+        std::vector<uint16_t> TwistMoves;
+        std::vector<uint16_t> FlipMoves;
+        std::vector<uint16_t> SliceMoves;
+        std::vector<uint16_t> CornerPermutationMoves;
+        std::vector<uint16_t> EdgePermutationMoves;
+        std::vector<uint16_t> SlicePermutationMoves;
+
+        const uint8_t* TwistSlicePruning = nullptr;
+        const uint8_t* FlipSlicePruning = nullptr;
+        const uint8_t* CornerSlicePruning = nullptr;
+        const uint8_t* EdgeSlicePruning = nullptr;
+
+        struct FSearch
+        {
+            const FCubies& Start;
+            int32_t MaxTotal;
+            std::atomic<bool>& Stop;
+            FSearchControl* Control;
+            int32_t Path[MaxSolutionLength];
+            int32_t Length = 0;
+            int64_t Nodes = 0;
+        };
+
+        static constexpr int64_t NodeFlushInterval = 4096;
+
+        // 节点数攒够一批再累加到共享计数上，顺便检查取消
+        static void FlushNodes(FSearch& Search)
+        {
+            if (Search.Control != nullptr)
+            {
+                Search.Control->AddNodes(Search.Nodes);
+                if (Search.Control->IsCancelled())
+                {
+                    Search.Stop.store(true, std::memory_order_relaxed);
+                }
+            }
+            Search.Nodes = 0;
+        }
+
+        static void CountNode(FSearch& Search)
+        {
+            if (++Search.Nodes == NodeFlushInterval)
+            {
+                FlushNodes(Search);
+            }
+        }
+
+        static int32_t FaceIndex(int32_t Axis, int32_t Coord) { return Axis * 2 + (Coord == 2 ? 0 : 1); }
+
+        template <typename FGetFace>
+        static int32_t GetStickerFace(int32_t Slot, int32_t Face, FGetFace& GetFace)
+        {
+            const int32_t Coords[3] = { Slot % 3, (Slot / 3) % 3, Slot / 9 };
+            const int32_t Axis = Face / 2;
+            return GetFace(Face, Coords[(Axis + 1) % 3], Coords[(Axis + 2) % 3]);
+        }
+
+        static int32_t RotateFace(int32_t Face, const int32_t (&M)[3][3])
+        {
+            const int32_t Axis = Face / 2;
+            const int32_t Sign = (Face % 2 == 0) ? 1 : -1;
+            for (int32_t Row = 0; Row < 3; Row++)
+            {
+                if (M[Row][Axis] != 0)
+                {
+                    return Row * 2 + (Sign * M[Row][Axis] > 0 ? 0 : 1);
+                }
+            }
+            return Face;
+        }
+
+        void BuildGeometry()
+        {
+            for (int32_t Slot = 0; Slot < 27; Slot++)
+            {
+                SlotToCorner[Slot] = -1;
+                SlotToEdge[Slot] = -1;
+            }
+
+            // 上下两层的 8 条棱在前，中层 4 条棱在后，这样第二阶段两类棱各占一段
+            int32_t NumCornerSlots = 0;
+            int32_t NumUDEdges = 0;
+            int32_t NumSliceEdges = 0;
+            for (int32_t Slot = 0; Slot < 27; Slot++)
+            {
+                const int32_t Coords[3] = { Slot % 3, (Slot / 3) % 3, Slot / 9 };
+                const int32_t NumMiddle = (Coords[0] == 1) + (Coords[1] == 1) + (Coords[2] == 1);
+                if (NumMiddle == 0)
+                {
+                    // 三个面按从外面看的同一旋向排列，第一个是 Z 面；所有角块朝向之和始终是 3 的倍数
+                    const int32_t Index = NumCornerSlots++;
+                    const bool bRightHanded = (((Coords[0] + Coords[1] + Coords[2]) / 2) & 1) == 1;
+                    CornerSlots[Index] = Slot;
+                    SlotToCorner[Slot] = Index;
+                    CornerFaces[Index][0] = FaceIndex(2, Coords[2]);
+                    CornerFaces[Index][1] = bRightHanded ? FaceIndex(0, Coords[0]) : FaceIndex(1, Coords[1]);
+                    CornerFaces[Index][2] = bRightHanded ? FaceIndex(1, Coords[1]) : FaceIndex(0, Coords[0]);
+                }
+                else if (NumMiddle == 1)
+                {
+                    // 参考面：上下层的棱取 Z 面，中层的棱取 Y 面；只有 Y 轴的 90° 转动会改变棱块朝向
+                    const bool bSlice = Coords[2] == 1;
+                    const int32_t Index = bSlice ? 8 + NumSliceEdges++ : NumUDEdges++;
+                    const int32_t OtherAxis = bSlice ? 0 : (Coords[0] == 1 ? 1 : 0);
+                    EdgeSlots[Index] = Slot;
+                    SlotToEdge[Slot] = Index;
+                    EdgeFaces[Index][0] = bSlice ? FaceIndex(1, Coords[1]) : FaceIndex(2, Coords[2]);
+                    EdgeFaces[Index][1] = FaceIndex(OtherAxis, Coords[OtherAxis]);
+                }
+            }
+
+            int32_t NumPhase2 = 0;
+            for (int32_t Move = 0; Move < NumMoves; Move++)
+            {
+                const int32_t Axis = Move / 6;
+                const int32_t Turns = Move % 3 + 1;
+                if (Axis == 2 || Turns == 2)
+                {
+                    Phase2Moves[NumPhase2++] = Move;
+                }
+
+                const int32_t Layer = ((Move / 3) % 2 == 1) ? 2 : 0;
+                const int32_t (&M)[3][3] = OrientationTable.Matrices[OrientationTable.QuarterTurns[Axis][Turns]];
+                auto RotateSlot = [&M](int32_t Slot)
+                {
+                    const int32_t Coords[3] = { Slot % 3 - 1, (Slot / 3) % 3 - 1, Slot / 9 - 1 };
+                    int32_t Target[3] = {};
+                    for (int32_t Row = 0; Row < 3; Row++)
+                    {
+                        Target[Row] = M[Row][0] * Coords[0] + M[Row][1] * Coords[1] + M[Row][2] * Coords[2] + 1;
+                    }
+                    return Target[0] + Target[1] * 3 + Target[2] * 9;
+                };
+
+                for (int32_t Corner = 0; Corner < NumCorners; Corner++)
+                {
+                    const int32_t Slot = CornerSlots[Corner];
+                    const bool bInLayer = ((Axis == 0 ? Slot % 3 : (Axis == 1 ? (Slot / 3) % 3 : Slot / 9))) == Layer;
+                    const int32_t Target = SlotToCorner[bInLayer ? RotateSlot(Slot) : Slot];
+                    CornerTargets[Move][Corner] = Target;
+                    for (int32_t Twist = 0; Twist < 3; Twist++)
+                    {
+                        const int32_t Face = bInLayer ? RotateFace(CornerFaces[Corner][Twist], M) : CornerFaces[Corner][Twist];
+                        TwistTargets[Move][Corner][Twist] = Face == CornerFaces[Target][0] ? 0 : (Face == CornerFaces[Target][1] ? 1 : 2);
+                    }
+                }
+                for (int32_t Edge = 0; Edge < NumEdges; Edge++)
+                {
+                    const int32_t Slot = EdgeSlots[Edge];
+                    const bool bInLayer = ((Axis == 0 ? Slot % 3 : (Axis == 1 ? (Slot / 3) % 3 : Slot / 9))) == Layer;
+                    const int32_t Target = SlotToEdge[bInLayer ? RotateSlot(Slot) : Slot];
+                    EdgeTargets[Move][Edge] = Target;
+                    for (int32_t Flip = 0; Flip < 2; Flip++)
+                    {
+                        const int32_t Face = bInLayer ? RotateFace(EdgeFaces[Edge][Flip], M) : EdgeFaces[Edge][Flip];
+                        FlipTargets[Move][Edge][Flip] = Face == EdgeFaces[Target][0] ? 0 : 1;
+                    }
+                }
+            }
+        }
+
+        void ApplyMove(FCubies& Cubies, int32_t Move) const
+        {
+            FCubies Moved = Cubies;
+            for (int32_t Corner = 0; Corner < NumCorners; Corner++)
+            {
+                const int32_t Target = CornerTargets[Move][Corner];
+                Moved.Corners[Target] = Cubies.Corners[Corner];
+                Moved.Twists[Target] = static_cast<uint8_t>(TwistTargets[Move][Corner][Cubies.Twists[Corner]]);
+            }
+            for (int32_t Edge = 0; Edge < NumEdges; Edge++)
+            {
+                const int32_t Target = EdgeTargets[Move][Edge];
+                Moved.Edges[Target] = Cubies.Edges[Edge];
+                Moved.Flips[Target] = static_cast<uint8_t>(FlipTargets[Move][Edge][Cubies.Flips[Edge]]);
+            }
+            Cubies = Moved;
+        }
+
+        // ---- 坐标编码 ----
+
+        static int32_t EncodeTwist(const uint8_t Twists[NumCorners])
+        {
+            int32_t Index = 0;
+            for (int32_t i = NumCorners - 2; i >= 0; i--)
+            {
+                Index = Index * 3 + Twists[i];
+            }
+            return Index;
+        }
+
+        static void DecodeTwist(int32_t Index, uint8_t OutTwists[NumCorners])
+        {
+            int32_t Sum = 0;
+            for (int32_t i = 0; i < NumCorners - 1; i++)
+            {
+                OutTwists[i] = static_cast<uint8_t>(Index % 3);
+                Sum += Index % 3;
+                Index /= 3;
+            }
+            OutTwists[NumCorners - 1] = static_cast<uint8_t>((3 - Sum % 3) % 3);
+        }
+
+        static int32_t EncodeFlip(const uint8_t Flips[NumEdges])
+        {
+            int32_t Index = 0;
+            for (int32_t i = NumEdges - 2; i >= 0; i--)
+            {
+                Index = Index * 2 + Flips[i];
+            }
+            return Index;
+        }
+
+        static void DecodeFlip(int32_t Index, uint8_t OutFlips[NumEdges])
+        {
+            int32_t Sum = 0;
+            for (int32_t i = 0; i < NumEdges - 1; i++)
+            {
+                OutFlips[i] = static_cast<uint8_t>(Index & 1);
+                Sum += Index & 1;
+                Index >>= 1;
+            }
+            OutFlips[NumEdges - 1] = static_cast<uint8_t>(Sum & 1);
+        }
+
+        static int32_t Choose(int32_t N, int32_t K)
+        {
+            if (K < 0 || K > N)
+            {
+                return 0;
+            }
+            int32_t Result = 1;
+            for (int32_t i = 0; i < K; i++)
+            {
+                Result = Result * (N - i) / (i + 1);
+            }
+            return Result;
+        }
+
+        // 中层棱（方块 8..11）所在的 4 个槽位组合，组合数编码
+        static int32_t EncodeSlice(const uint8_t Edges[NumEdges])
+        {
+            int32_t Index = 0;
+            int32_t Found = 0;
+            for (int32_t Slot = 0; Slot < NumEdges; Slot++)
+            {
+                if (Edges[Slot] >= 8)
+                {
+                    Found++;
+                    Index += Choose(Slot, Found);
+                }
+            }
+            return Index;
+        }
+
+        static void DecodeSlice(int32_t Index, uint8_t OutEdges[NumEdges])
+        {
+            int32_t Remaining = 4;
+            int32_t NextSlice = 8;
+            int32_t NextOther = 0;
+            for (int32_t Slot = NumEdges - 1; Slot >= 0; Slot--)
+            {
+                const int32_t Combinations = Choose(Slot, Remaining);
+                if (Remaining > 0 && Index >= Combinations)
+                {
+                    Index -= Combinations;
+                    Remaining--;
+                    OutEdges[Slot] = static_cast<uint8_t>(NextSlice++);
+                }
+                else
+                {
+                    OutEdges[Slot] = static_cast<uint8_t>(NextOther++);
+                }
+            }
+        }
+
+        // Count 个互不相同元素的排列，Lehmer 编码（只看相对大小）
+        static int32_t EncodePermutation(const uint8_t* Values, int32_t Count)
+        {
+            int32_t Index = 0;
+            for (int32_t i = 0; i < Count; i++)
+            {
+                int32_t Smaller = 0;
+                for (int32_t j = i + 1; j < Count; j++)
+                {
+                    Smaller += Values[j] < Values[i] ? 1 : 0;
+                }
+                Index = Index * (Count - i) + Smaller;
+            }
+            return Index;
+        }
+
+        // 解码为 Base..Base+Count-1 的排列
+        static void DecodePermutation(int32_t Index, uint8_t* OutValues, int32_t Count, int32_t Base)
+        {
+            int32_t Codes[NumEdges] = {};
+            for (int32_t i = Count - 1; i >= 0; i--)
+            {
+                Codes[i] = Index % (Count - i);
+                Index /= Count - i;
+            }
+
+            bool bUsed[NumEdges] = {};
+            for (int32_t i = 0; i < Count; i++)
+            {
+                int32_t Value = 0;
+                for (int32_t Skip = Codes[i]; bUsed[Value] || Skip > 0; Value++)
+                {
+                    Skip -= bUsed[Value] ? 0 : 1;
+                }
+                bUsed[Value] = true;
+                OutValues[i] = static_cast<uint8_t>(Base + Value);
+            }
+        }
+
+        void BuildMoveTables()
+        {
+            TwistMoves.resize(NumTwists * NumMoves);
+            FlipMoves.resize(NumFlips * NumMoves);
+            SliceMoves.resize(NumSlices * NumMoves);
+            CornerPermutationMoves.resize(NumCornerPermutations * NumPhase2Moves);
+            EdgePermutationMoves.resize(NumEdgePermutations * NumPhase2Moves);
+            SlicePermutationMoves.resize(NumSlicePermutations * NumPhase2Moves);
+
+            FCubies Cubies;
+            for (int32_t Twist = 0; Twist < NumTwists; Twist++)
+            {
+                for (int32_t Move = 0; Move < NumMoves; Move++)
+                {
+                    DecodeTwist(Twist, Cubies.Twists);
+                    ApplyMove(Cubies, Move);
+                    TwistMoves[Twist * NumMoves + Move] = static_cast<uint16_t>(EncodeTwist(Cubies.Twists));
+                }
+            }
+            for (int32_t Flip = 0; Flip < NumFlips; Flip++)
+            {
+                for (int32_t Move = 0; Move < NumMoves; Move++)
+                {
+                    DecodeFlip(Flip, Cubies.Flips);
+                    ApplyMove(Cubies, Move);
+                    FlipMoves[Flip * NumMoves + Move] = static_cast<uint16_t>(EncodeFlip(Cubies.Flips));
+                }
+            }
+            for (int32_t Slice = 0; Slice < NumSlices; Slice++)
+            {
+                for (int32_t Move = 0; Move < NumMoves; Move++)
+                {
+                    DecodeSlice(Slice, Cubies.Edges);
+                    ApplyMove(Cubies, Move);
+                    SliceMoves[Slice * NumMoves + Move] = static_cast<uint16_t>(EncodeSlice(Cubies.Edges));
+                }
+            }
+
+            // 第二阶段：上下层棱占槽位 0..7、中层棱占 8..11，子群内的转动不会让两类棱互换
+            for (int32_t Permutation = 0; Permutation < NumCornerPermutations; Permutation++)
+            {
+                for (int32_t Phase2Move = 0; Phase2Move < NumPhase2Moves; Phase2Move++)
+                {
+                    DecodePermutation(Permutation, Cubies.Corners, NumCorners, 0);
+                    DecodePermutation(Permutation, Cubies.Edges, 8, 0);
+                    DecodePermutation(0, Cubies.Edges + 8, 4, 8);
+                    ApplyMove(Cubies, Phase2Moves[Phase2Move]);
+                    CornerPermutationMoves[Permutation * NumPhase2Moves + Phase2Move] = static_cast<uint16_t>(EncodePermutation(Cubies.Corners, NumCorners));
+                    EdgePermutationMoves[Permutation * NumPhase2Moves + Phase2Move] = static_cast<uint16_t>(EncodePermutation(Cubies.Edges, 8));
+                }
+            }
+            for (int32_t Permutation = 0; Permutation < NumSlicePermutations; Permutation++)
+            {
+                for (int32_t Phase2Move = 0; Phase2Move < NumPhase2Moves; Phase2Move++)
+                {
+                    DecodePermutation(0, Cubies.Edges, 8, 0);
+                    DecodePermutation(Permutation, Cubies.Edges + 8, 4, 8);
+                    ApplyMove(Cubies, Phase2Moves[Phase2Move]);
+                    SlicePermutationMoves[Permutation * NumPhase2Moves + Phase2Move] = static_cast<uint16_t>(EncodePermutation(Cubies.Edges + 8, 4));
+                }
+            }
+        }
+
+        // ---- 剪枝表 ----
+
+        static uint8_t GetDistance(const uint8_t* Table, int32_t Index)
+        {
+            return (Table[Index >> 1] >> ((Index & 1) * 4)) & 0xF;
+        }
+
+        static void SetDistance(uint8_t* Table, int32_t Index, uint8_t Distance)
+        {
+            const int32_t Shift = (Index & 1) * 4;
+            Table[Index >> 1] = static_cast<uint8_t>((Table[Index >> 1] & ~(0xF << Shift)) | (Distance << Shift));
+        }
+
+        // 坐标对 (A, B) 上的广度优先，目标为 (0, SolvedB)
+        static void BuildPruningTable(uint8_t* OutTable, int32_t NumA, const uint16_t* MovesA, int32_t NumB, int32_t SolvedB, const uint16_t* MovesB, int32_t NumTableMoves)
+        {
+            const int32_t NumEntries = NumA * NumB;
+            for (int32_t i = 0; i < (NumEntries + 1) / 2; i++)
+            {
+                OutTable[i] = 0xFF;
+            }
+
+            std::vector<uint32_t> Queue;
+            Queue.reserve(NumEntries);
+            Queue.push_back(static_cast<uint32_t>(SolvedB));
+            SetDistance(OutTable, SolvedB, 0);
+            for (std::size_t Head = 0; Head < Queue.size(); Head++)
+            {
+                const int32_t Entry = static_cast<int32_t>(Queue[Head]);
+                const int32_t A = Entry / NumB;
+                const int32_t B = Entry % NumB;
+                const uint8_t NextDistance = static_cast<uint8_t>(GetDistance(OutTable, Entry) + 1);
+                for (int32_t Move = 0; Move < NumTableMoves; Move++)
+                {
+                    const int32_t Next = MovesA[A * NumTableMoves + Move] * NumB + MovesB[B * NumTableMoves + Move];
+                    if (GetDistance(OutTable, Next) == 0xF)
+                    {
+                        SetDistance(OutTable, Next, NextDistance);
+                        Queue.push_back(static_cast<uint32_t>(Next));
+                    }
+                }
+            }
+        }
+
+        int32_t Phase1Estimate(int32_t Twist, int32_t Flip, int32_t Slice) const
+        {
+            const int32_t A = GetDistance(TwistSlicePruning, Twist * NumSlices + Slice);
+            const int32_t B = GetDistance(FlipSlicePruning, Flip * NumSlices + Slice);
+            return A > B ? A : B;
+        }
+
+        int32_t Phase2Estimate(int32_t CornerPermutation, int32_t EdgePermutation, int32_t SlicePermutation) const
+        {
+            const int32_t A = GetDistance(CornerSlicePruning, CornerPermutation * NumSlicePermutations + SlicePermutation);
+            const int32_t B = GetDistance(EdgeSlicePruning, EdgePermutation * NumSlicePermutations + SlicePermutation);
+            return A > B ? A : B;
+        }
+
+        // 同一面连续转动可以合并；相对的两个面可交换，只保留一种先后顺序
+        static bool IsRedundant(int32_t Move, int32_t LastFace)
+        {
+            const int32_t Face = Move / 3;
+            return LastFace >= 0 && (Face == LastFace || (Face / 2 == LastFace / 2 && Face < LastFace));
+        }
+
+        static bool IsPhase2Move(int32_t Move)
+        {
+            return Move / 6 == 2 || Move % 3 == 1;
+        }
+
+        // ---- 搜索 ----
+
+        bool SearchPhase1(FSearch& Search, int32_t Twist, int32_t Flip, int32_t Slice, int32_t Depth, int32_t Bound, int32_t LastFace) const
+        {
+            CountNode(Search);
+            if (Search.Stop.load(std::memory_order_relaxed))
+            {
+                return false;
+            }
+
+            const int32_t Estimate = Phase1Estimate(Twist, Flip, Slice);
+            if (Depth == Bound)
+            {
+                // 最后一步若本身就在子群内，去掉它会得到更短的第一阶段解，那种情况已经在更浅的深度试过
+                return Estimate == 0 && !IsPhase2Move(Search.Path[Depth - 1]) && SearchPhase2(Search, Depth);
+            }
+            if (Depth + Estimate > Bound)
+            {
+                return false;
+            }
+
+            for (int32_t Move = 0; Move < NumMoves; Move++)
+            {
+                if (IsRedundant(Move, LastFace))
+                {
+                    continue;
+                }
+                Search.Path[Depth] = Move;
+                if (SearchPhase1(Search, TwistMoves[Twist * NumMoves + Move], FlipMoves[Flip * NumMoves + Move],
+                    SliceMoves[Slice * NumMoves + Move], Depth + 1, Bound, Move / 3))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool SearchPhase2(FSearch& Search, int32_t Phase1Length) const
+        {
+            // 沿第一阶段路径推进完整的方块排列，得到第二阶段坐标
+            FCubies Cubies = Search.Start;
+            for (int32_t i = 0; i < Phase1Length; i++)
+            {
+                ApplyMove(Cubies, Search.Path[i]);
+            }
+            const int32_t CornerPermutation = EncodePermutation(Cubies.Corners, NumCorners);
+            const int32_t EdgePermutation = EncodePermutation(Cubies.Edges, 8);
+            const int32_t SlicePermutation = EncodePermutation(Cubies.Edges + 8, 4);
+
+            const int32_t LastFace = Phase1Length > 0 ? Search.Path[Phase1Length - 1] / 3 : -1;
+            const int32_t MaxDepth = Search.MaxTotal - Phase1Length < MaxPhase2Depth ? Search.MaxTotal - Phase1Length : MaxPhase2Depth;
+            for (int32_t Bound = Phase2Estimate(CornerPermutation, EdgePermutation, SlicePermutation); Bound <= MaxDepth; Bound++)
+            {
+                if (SearchPhase2Recursive(Search, CornerPermutation, EdgePermutation, SlicePermutation, Phase1Length, Phase1Length + Bound, LastFace))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool SearchPhase2Recursive(FSearch& Search, int32_t CornerPermutation, int32_t EdgePermutation, int32_t SlicePermutation, int32_t Depth, int32_t Bound, int32_t LastFace) const
+        {
+            CountNode(Search);
+            const int32_t Estimate = Phase2Estimate(CornerPermutation, EdgePermutation, SlicePermutation);
+            if (Estimate == 0)
+            {
+                Search.Length = Depth;
+                return true;
+            }
+            if (Depth + Estimate > Bound)
+            {
+                return false;
+            }
+
+            for (int32_t Phase2Move = 0; Phase2Move < NumPhase2Moves; Phase2Move++)
+            {
+                const int32_t Move = Phase2Moves[Phase2Move];
+                if (IsRedundant(Move, LastFace))
+                {
+                    continue;
+                }
+                Search.Path[Depth] = Move;
+                if (SearchPhase2Recursive(Search, CornerPermutationMoves[CornerPermutation * NumPhase2Moves + Phase2Move],
+                    EdgePermutationMoves[EdgePermutation * NumPhase2Moves + Phase2Move],
+                    SlicePermutationMoves[SlicePermutation * NumPhase2Moves + Phase2Move], Depth + 1, Bound, Move / 3))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+}
@@ -0,0 +1,266 @@
+// Teng：魔方纯逻辑核心的性能测试，不依赖引擎；对应编辑器里的 MagicCube.Benchmark* 控制台命令，但全部单线程
+// 用法：MagicCubeCoreBenchmark [facelets|moves|pocket|twophase|reduction|all] [参数...]
+//   facelets  [最大阶数=50] [每个阶数的步数=20000]   逐方块 FCubeState 与贴纸级 FFaceletCube 的每秒转动次数
+//   moves     [最大阶数=20] [每个阶数的步数=20000]   FCubeState 逐步 ApplyMove 与批量 ApplyMoves 的对比
+//   pocket    [状态数=1000]                           2 阶最优解的平均/最大延迟（含距离表生成时间）
+//   twophase  [状态数=200] [目标步数=23]              3 阶两阶段解的平均/最大延迟（含剪枝表生成时间）
+//   reduction [最大阶数=20] [打乱步数=200]            4 阶及以上降阶法的总时间、第一步输出延迟、步数
+
+#include "MagicCubeCore.h"
+#include "MagicCubeFacelets.h"
+#include "MagicCubePocketSolver.h"
+#include "MagicCubeReductionSolver.h"
+#include "MagicCubeTwoPhaseSolver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace MagicCube;
+
+namespace
+{
+    double Now()
+    {
+        using FClock = std::chrono::steady_clock;
+        return std::chrono::duration<double>(FClock::now().time_since_epoch()).count();
+    }
+
+    int32_t GetIntArg(int Argc, char** Argv, int Index, int32_t Default)
+    {
+        return Index < Argc ? std::atoi(Argv[Index]) : Default;
+    }
+
+    std::vector<FLayerTurn> RandomMoves(std::mt19937& Random, int32_t Order, int32_t NumMoves)
+    {
+        std::vector<FLayerTurn> Moves(static_cast<size_t>(NumMoves));
+        for (FLayerTurn& Move : Moves)
+        {
+            Move.AxisIndex = static_cast<int32_t>(Random() % 3);
+            Move.Layer = static_cast<int32_t>(Random() % static_cast<uint32_t>(Order));
+            Move.QuarterTurns = 1 + static_cast<int32_t>(Random() % 3);
+        }
+        return Moves;
+    }
+
+    const FTwoPhaseSolver& GetTwoPhaseSolver()
+    {
+        static std::vector<uint8_t> Tables;
+        static const std::unique_ptr<FTwoPhaseSolver> Solver = []()
+        {
+            const double Start = Now();
+            std::unique_ptr<FTwoPhaseSolver> NewSolver(new FTwoPhaseSolver());
+            Tables.resize(FTwoPhaseSolver::PruningTableBytes);
+            NewSolver->BuildPruningTables(Tables.data());
+            NewSolver->SetPruningTables(Tables.data());
+            std::printf("Two-phase tables built in %.1f ms (%d bytes)\n", (Now() - Start) * 1000.0, FTwoPhaseSolver::PruningTableBytes);
+            return NewSolver;
+        }();
+        return *Solver;
+    }
+
+    void RunFaceletBenchmark(int32_t MaxOrder, int32_t NumMoves)
+    {
+        std::mt19937 Random(12345);
+        for (int32_t Order = 3; Order <= MaxOrder; Order++)
+        {
+            const std::vector<FLayerTurn> Moves = RandomMoves(Random, Order, NumMoves);
+
+            FCubeState CubieState;
+            CubieState.Initialize(FCoords{ Order, Order, Order }, nullptr, 0);
+            const double CubieStart = Now();
+            for (const FLayerTurn& Move : Moves)
+            {
+                CubieState.ApplyMove(Move.AxisIndex, Move.Layer, Move.QuarterTurns);
+            }
+            const double CubieSeconds = Now() - CubieStart;
+
+            FFaceletCube Facelets;
+            Facelets.Initialize(Order);
+            const double FaceletStart = Now();
+            Facelets.ApplyMoves(Moves.data(), NumMoves);
+            const double FaceletSeconds = Now() - FaceletStart;
+
+            std::printf("N=%d  cubie: %.0f moves/s  facelet: %.0f moves/s  (x%.1f)\n",
+                Order,
+                NumMoves / std::max(CubieSeconds, 1e-9),
+                NumMoves / std::max(FaceletSeconds, 1e-9),
+                CubieSeconds / std::max(FaceletSeconds, 1e-9));
+        }
+    }
+
+    void RunMovesBenchmark(int32_t MaxOrder, int32_t NumMoves)
+    {
+        std::mt19937 Random(12345);
+        for (int32_t Order = 2; Order <= MaxOrder; Order++)
+        {
+            const std::vector<FLayerTurn> Moves = RandomMoves(Random, Order, NumMoves);
+
+            FCubeState Single;
+            Single.Initialize(FCoords{ Order, Order, Order }, nullptr, 0);
+            const double SingleStart = Now();
+            for (const FLayerTurn& Move : Moves)
+            {
+                Single.ApplyMove(Move.AxisIndex, Move.Layer, Move.QuarterTurns);
+            }
+            const double SingleSeconds = Now() - SingleStart;
+
+            FCubeState Bulk;
+            Bulk.Initialize(FCoords{ Order, Order, Order }, nullptr, 0);
+            const double BulkStart = Now();
+            Bulk.ApplyMoves(Moves.data(), NumMoves);
+            const double BulkSeconds = Now() - BulkStart;
+
+            std::printf("N=%d  ApplyMove: %.0f moves/s  ApplyMoves: %.0f moves/s  (x%.1f)\n",
+                Order,
+                NumMoves / std::max(SingleSeconds, 1e-9),
+                NumMoves / std::max(BulkSeconds, 1e-9),
+                SingleSeconds / std::max(BulkSeconds, 1e-9));
+        }
+    }
+
+    void RunPocketBenchmark(int32_t NumStates)
+    {
+        const double BuildStart = Now();
+        std::vector<uint8_t> Table(FPocketCubeSolver::DistanceTableBytes);
+        FPocketCubeSolver Solver;
+        Solver.BuildDistanceTable(Table.data());
+        Solver.SetDistanceTable(Table.data());
+        std::printf("Pocket distance table built in %.1f ms (%d bytes)\n", (Now() - BuildStart) * 1000.0, FPocketCubeSolver::DistanceTableBytes);
+
+        std::mt19937 Random(12345);
+        std::vector<FLayerTurn> Solution;
+        double TotalSeconds = 0.0;
+        double MaxSeconds = 0.0;
+        int64_t TotalLength = 0;
+        int32_t NumFailed = 0;
+        for (int32_t i = 0; i < NumStates; i++)
+        {
+            FCubeState State;
+            State.Initialize(FCoords{ 2, 2, 2 }, nullptr, 0);
+            const std::vector<FLayerTurn> Scramble = RandomMoves(Random, 2, 30);
+            State.ApplyMoves(Scramble.data(), static_cast<int32_t>(Scramble.size()));
+
+            const double Start = Now();
+            const bool bSolved = Solver.Solve(State, Solution);
+            const double Seconds = Now() - Start;
+            TotalSeconds += Seconds;
+            MaxSeconds = std::max(MaxSeconds, Seconds);
+
+            State.ApplyMoves(Solution.data(), static_cast<int32_t>(Solution.size()));
+            NumFailed += (bSolved && State.IsSolved()) ? 0 : 1;
+            TotalLength += static_cast<int64_t>(Solution.size());
+        }
+
+        std::printf("Pocket: %d states  avg %.3f ms  max %.3f ms  avg length %.2f  failed %d\n",
+            NumStates, TotalSeconds * 1000.0 / NumStates, MaxSeconds * 1000.0, static_cast<double>(TotalLength) / NumStates, NumFailed);
+    }
+
+    void RunTwoPhaseBenchmark(int32_t NumStates, int32_t TargetLength)
+    {
+        const FTwoPhaseSolver& Solver = GetTwoPhaseSolver();
+
+        std::mt19937 Random(12345);
+        std::vector<FLayerTurn> Solution;
+        double TotalSeconds = 0.0;
+        double MaxSeconds = 0.0;
+        int64_t TotalLength = 0;
+        int32_t NumFailed = 0;
+        for (int32_t i = 0; i < NumStates; i++)
+        {
+            FCubeState State;
+            State.Initialize(FCoords{ 3, 3, 3 }, nullptr, 0);
+            const std::vector<FLayerTurn> Scramble = RandomMoves(Random, 3, 40);
+            State.ApplyMoves(Scramble.data(), static_cast<int32_t>(Scramble.size()));
+
+            const double Start = Now();
+            const bool bSolved = Solver.Solve(State, TargetLength, Solution);
+            const double Seconds = Now() - Start;
+            TotalSeconds += Seconds;
+            MaxSeconds = std::max(MaxSeconds, Seconds);
+
+            State.ApplyMoves(Solution.data(), static_cast<int32_t>(Solution.size()));
+            NumFailed += (bSolved && State.IsSolved()) ? 0 : 1;
+            TotalLength += static_cast<int64_t>(Solution.size());
+        }
+
+        std::printf("Two-phase (single thread): %d states  target %d  avg %.3f ms  max %.3f ms  avg length %.2f  failed %d\n",
+            NumStates, TargetLength, TotalSeconds * 1000.0 / NumStates, MaxSeconds * 1000.0, static_cast<double>(TotalLength) / NumStates, NumFailed);
+    }
+
+    void RunReductionBenchmark(int32_t MaxOrder, int32_t NumScrambleMoves)
+    {
+        const FTwoPhaseSolver& ThreeByThree = GetTwoPhaseSolver();
+
+        std::mt19937 Random(12345);
+        for (int32_t Order = FReductionSolver::MinOrder; Order <= MaxOrder; Order++)
+        {
+            FFaceletCube Cube;
+            Cube.Initialize(Order);
+            const std::vector<FLayerTurn> Scramble = RandomMoves(Random, Order, NumScrambleMoves);
+            Cube.ApplyMoves(Scramble.data(), static_cast<int32_t>(Scramble.size()));
+
+            int64_t NumEmitted = 0;
+            double FirstMoveSeconds = -1.0;
+            const double Start = Now();
+            FReductionSolver Solver(ThreeByThree);
+            const bool bSolved = Solver.Solve(Cube, [&NumEmitted, &FirstMoveSeconds, Start](const FLayerTurn&)
+            {
+                if (NumEmitted++ == 0)
+                {
+                    FirstMoveSeconds = Now() - Start;
+                }
+            });
+            const double Seconds = Now() - Start;
+
+            std::printf("N=%d  %s  total %.1f ms  first move %.3f ms  moves %lld\n",
+                Order, bSolved ? "solved" : "FAILED", Seconds * 1000.0, std::max(FirstMoveSeconds, 0.0) * 1000.0, static_cast<long long>(NumEmitted));
+        }
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    const char* Mode = Argc > 1 ? Argv[1] : "all";
+    const bool bAll = std::strcmp(Mode, "all") == 0;
+    bool bRan = false;
+
+    if (bAll || std::strcmp(Mode, "facelets") == 0)
+    {
+        RunFaceletBenchmark(bAll ? 50 : GetIntArg(Argc, Argv, 2, 50), bAll ? 20000 : GetIntArg(Argc, Argv, 3, 20000));
+        bRan = true;
+    }
+    if (bAll || std::strcmp(Mode, "moves") == 0)
+    {
+        RunMovesBenchmark(bAll ? 20 : GetIntArg(Argc, Argv, 2, 20), bAll ? 20000 : GetIntArg(Argc, Argv, 3, 20000));
+        bRan = true;
+    }
+    if (bAll || std::strcmp(Mode, "pocket") == 0)
+    {
+        RunPocketBenchmark(bAll ? 1000 : std::max(1, GetIntArg(Argc, Argv, 2, 1000)));
+        bRan = true;
+    }
+    if (bAll || std::strcmp(Mode, "twophase") == 0)
+    {
+        RunTwoPhaseBenchmark(bAll ? 200 : std::max(1, GetIntArg(Argc, Argv, 2, 200)), bAll ? 23 : GetIntArg(Argc, Argv, 3, 23));
+        bRan = true;
+    }
+    if (bAll || std::strcmp(Mode, "reduction") == 0)
+    {
+        RunReductionBenchmark(bAll ? 20 : GetIntArg(Argc, Argv, 2, 20), bAll ? 200 : GetIntArg(Argc, Argv, 3, 200));
+        bRan = true;
+    }
+
+    if (!bRan)
+    {
+        std::fprintf(stderr, "usage: %s [facelets|moves|pocket|twophase|reduction|all] [args...]\n", Argv[0]);
+        return 1;
+    }
+    return 0;
+}
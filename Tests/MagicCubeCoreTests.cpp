@@ -0,0 +1,590 @@
+// Teng：魔方纯逻辑核心的单元测试，不依赖引擎，也不依赖测试框架
+// 用法：MagicCubeCoreTests [用例名]，不带参数时跑全部用例；CMake 为每个用例单独注册一条 ctest
+
+#include "MagicCubeCore.h"
+#include "MagicCubeFacelets.h"
+#include "MagicCubePocketSolver.h"
+#include "MagicCubeReductionSolver.h"
+#include "MagicCubeTwoPhaseSolver.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace MagicCube;
+
+namespace
+{
+    int32_t NumFailures = 0;
+
+    #define CHECK(Condition) \
+        do \
+        { \
+            if (!(Condition)) \
+            { \
+                std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #Condition); \
+                NumFailures++; \
+            } \
+        } while (0)
+
+    // 两阶段求解器的剪枝表建一次要几秒，几个用例共用
+    const FTwoPhaseSolver& GetTwoPhaseSolver()
+    {
+        static std::vector<uint8_t> Tables;
+        static const std::unique_ptr<FTwoPhaseSolver> Solver = []()
+        {
+            std::unique_ptr<FTwoPhaseSolver> NewSolver(new FTwoPhaseSolver());
+            Tables.resize(FTwoPhaseSolver::PruningTableBytes);
+            NewSolver->BuildPruningTables(Tables.data());
+            NewSolver->SetPruningTables(Tables.data());
+            return NewSolver;
+        }();
+        return *Solver;
+    }
+
+    // 层是正方形时随机 1..3 个 90°，否则只能转半圈
+    FLayerTurn RandomLegalTurn(std::mt19937& Random, const FCoords& Dimensions)
+    {
+        FLayerTurn Turn;
+        Turn.AxisIndex = static_cast<int32_t>(Random() % 3);
+        Turn.Layer = static_cast<int32_t>(Random() % static_cast<uint32_t>(Dimensions[Turn.AxisIndex]));
+        const bool bSquare = Dimensions[(Turn.AxisIndex + 1) % 3] == Dimensions[(Turn.AxisIndex + 2) % 3];
+        Turn.QuarterTurns = bSquare ? 1 + static_cast<int32_t>(Random() % 3) : 2;
+        return Turn;
+    }
+
+    std::vector<FLayerTurn> RandomScramble(std::mt19937& Random, const FCoords& Dimensions, int32_t NumMoves)
+    {
+        std::vector<FLayerTurn> Moves;
+        for (int32_t i = 0; i < NumMoves; i++)
+        {
+            Moves.push_back(RandomLegalTurn(Random, Dimensions));
+        }
+        return Moves;
+    }
+
+    // 每个面颜色一致（奇数阶的降阶法可能整体转了方向，不要求是初始配色）
+    bool AreFacesUniform(const FFaceletCube& Cube)
+    {
+        const int32_t FaceSize = Cube.GetOrder() * Cube.GetOrder();
+        for (int32_t Face = 0; Face < FFaceletCube::NumFaces; Face++)
+        {
+            const uint8_t* Data = Cube.GetFaceData(Face);
+            for (int32_t i = 1; i < FaceSize; i++)
+            {
+                if (Data[i] != Data[0])
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool SameCubies(const FCubeState& A, const FCubeState& B)
+    {
+        if (A.GetNumCubies() != B.GetNumCubies())
+        {
+            return false;
+        }
+        for (int32_t Cubie = 0; Cubie < A.GetNumCubies(); Cubie++)
+        {
+            if (A.GetCubieSlot(Cubie) != B.GetCubieSlot(Cubie) || A.GetCubieOrientation(Cubie) != B.GetCubieOrientation(Cubie))
+            {
+                return false;
+            }
+        }
+        return A.GetStateHash() == B.GetStateHash();
+    }
+
+    void TestQuarterTurns()
+    {
+        CHECK(NormalizeQuarterTurns(-1) == 3);
+        CHECK(NormalizeQuarterTurns(5) == 1);
+        CHECK(NormalizeQuarterTurns(-8) == 0);
+        for (int32_t Turns = -9; Turns <= 9; Turns++)
+        {
+            const int32_t Signed = NormalizeSignedQuarterTurns(Turns);
+            CHECK(Signed >= -1 && Signed <= 2);
+            CHECK(NormalizeQuarterTurns(Signed) == NormalizeQuarterTurns(Turns));
+        }
+    }
+
+    void TestCubeStateMoveThenInverse()
+    {
+        std::mt19937 Random(1);
+        const FCoords AllDimensions[] = { { 2, 2, 2 }, { 3, 3, 3 }, { 4, 4, 4 }, { 5, 5, 5 }, { 2, 3, 4 }, { 3, 3, 5 } };
+        for (const FCoords& Dimensions : AllDimensions)
+        {
+            FCubeState State;
+            State.Initialize(Dimensions, nullptr, 0);
+            const std::vector<FLayerTurn> Moves = RandomScramble(Random, Dimensions, 200);
+            for (const FLayerTurn& Move : Moves)
+            {
+                CHECK(State.ApplyMove(Move.AxisIndex, Move.Layer, Move.QuarterTurns));
+            }
+            for (auto It = Moves.rbegin(); It != Moves.rend(); ++It)
+            {
+                CHECK(State.ApplyMove(It->AxisIndex, It->Layer, -It->QuarterTurns));
+            }
+            CHECK(State.IsAtHome());
+            CHECK(State.IsSolved());
+        }
+    }
+
+    void TestCubeStateFourQuarterTurns()
+    {
+        for (int32_t Order = 2; Order <= 6; Order++)
+        {
+            FCubeState State;
+            State.Initialize(FCoords{ Order, Order, Order }, nullptr, 0);
+            for (int32_t AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+            {
+                for (int32_t Layer = 0; Layer < Order; Layer++)
+                {
+                    CHECK(State.ApplyMove(AxisIndex, Layer, 1));
+                    CHECK(!State.IsAtHome());
+                    for (int32_t i = 0; i < 3; i++)
+                    {
+                        State.ApplyMove(AxisIndex, Layer, 1);
+                    }
+                    CHECK(State.IsAtHome());
+                }
+            }
+        }
+    }
+
+    void TestCubeStateRejectsIllegalTurn()
+    {
+        // 2x3x4 绕 X 轴的层是 3x4，转 90° 会越界
+        FCubeState State;
+        State.Initialize(FCoords{ 2, 3, 4 }, nullptr, 0);
+        const uint64_t Hash = State.GetStateHash();
+        CHECK(!State.ApplyMove(0, 0, 1));
+        CHECK(!State.ApplyMove(0, 1, -1));
+        CHECK(State.IsAtHome());
+        CHECK(State.GetStateHash() == Hash);
+        CHECK(State.ApplyMove(0, 0, 2));
+        CHECK(!State.ApplyMove(3, 0, 1));
+        CHECK(!State.ApplyMove(0, 2, 2));
+    }
+
+    void TestCubeStateLayerTables()
+    {
+        std::mt19937 Random(2);
+        const FCoords AllDimensions[] = { { 3, 3, 3 }, { 4, 4, 4 }, { 2, 3, 4 } };
+        for (const FCoords& Dimensions : AllDimensions)
+        {
+            FCubeState State;
+            State.Initialize(Dimensions, nullptr, 0);
+            for (int32_t Step = 0; Step < 100; Step++)
+            {
+                const FLayerTurn Move = RandomLegalTurn(Random, Dimensions);
+                State.ApplyMove(Move.AxisIndex, Move.Layer, Move.QuarterTurns);
+                for (int32_t AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+                {
+                    int32_t Total = 0;
+                    for (int32_t Layer = 0; Layer < Dimensions[AxisIndex]; Layer++)
+                    {
+                        for (int32_t Cubie : State.GetLayerCubies(AxisIndex, Layer))
+                        {
+                            CHECK(State.GetSlotCoords(State.GetCubieSlot(Cubie))[AxisIndex] == Layer);
+                            Total++;
+                        }
+                    }
+                    CHECK(Total == State.GetNumCubies());
+                }
+            }
+        }
+    }
+
+    void TestCubeStateApplyMovesMatchesApplyMove()
+    {
+        // 2、3 阶走固定阶数内核，其他走通用路径，结果都要和逐步转动一致
+        std::mt19937 Random(3);
+        const FCoords AllDimensions[] = { { 2, 2, 2 }, { 3, 3, 3 }, { 5, 5, 5 }, { 2, 3, 4 } };
+        for (const FCoords& Dimensions : AllDimensions)
+        {
+            const std::vector<FLayerTurn> Moves = RandomScramble(Random, Dimensions, 500);
+            FCubeState Bulk;
+            Bulk.Initialize(Dimensions, nullptr, 0);
+            CHECK(Bulk.ApplyMoves(Moves.data(), static_cast<int32_t>(Moves.size())) == static_cast<int32_t>(Moves.size()));
+
+            FCubeState Single;
+            Single.Initialize(Dimensions, nullptr, 0);
+            for (const FLayerTurn& Move : Moves)
+            {
+                Single.ApplyMove(Move.AxisIndex, Move.Layer, Move.QuarterTurns);
+            }
+            CHECK(SameCubies(Bulk, Single));
+            CHECK(Bulk.IsAtHome() == Single.IsAtHome());
+        }
+    }
+
+    void TestCubeStateWholeCubeTurnIsSolved()
+    {
+        for (int32_t Order = 2; Order <= 5; Order++)
+        {
+            FCubeState State;
+            State.Initialize(FCoords{ Order, Order, Order }, nullptr, 0);
+            for (int32_t Layer = 0; Layer < Order; Layer++)
+            {
+                State.ApplyMove(2, Layer, 1);
+            }
+            CHECK(!State.IsAtHome());
+            CHECK(State.IsSolved());
+
+            State.ApplyMove(0, 0, 1);
+            CHECK(!State.IsSolved());
+        }
+    }
+
+    void TestCubeStateLayoutMask()
+    {
+        // 中心一格挖空
+        const int32_t Order = 3;
+        std::vector<uint8_t> Mask(Order * Order * Order, 1);
+        Mask[1 + 1 * Order + 1 * Order * Order] = 0;
+        bool MaskBools[Order * Order * Order];
+        for (int32_t i = 0; i < Order * Order * Order; i++)
+        {
+            MaskBools[i] = Mask[i] != 0;
+        }
+
+        FCubeState State;
+        State.Initialize(FCoords{ Order, Order, Order }, MaskBools, Order * Order * Order);
+        CHECK(State.GetNumCubies() == Order * Order * Order - 1);
+        CHECK(State.GetFixedOrder() == 0);
+        CHECK(State.GetCubieAtSlot(State.GetSlotIndex(1, 1, 1)) == InvalidIndex);
+
+        State.ApplyMove(1, 1, 1);
+        CHECK(State.GetCubieAtSlot(State.GetSlotIndex(1, 1, 1)) == InvalidIndex);
+        State.ApplyMove(1, 1, -1);
+        CHECK(State.IsAtHome());
+    }
+
+    // 方块编号可能不同，按槽位比较：每个槽位上是不是同一个初始槽位的方块、朝向是否相同
+    bool SameSlots(const FCubeState& A, const FCubeState& B)
+    {
+        if (A.GetNumSlots() != B.GetNumSlots() || A.GetNumCubies() != B.GetNumCubies())
+        {
+            return false;
+        }
+        for (int32_t Slot = 0; Slot < A.GetNumSlots(); Slot++)
+        {
+            const int32_t CubieA = A.GetCubieAtSlot(Slot);
+            const int32_t CubieB = B.GetCubieAtSlot(Slot);
+            if ((CubieA == InvalidIndex) != (CubieB == InvalidIndex))
+            {
+                return false;
+            }
+            if (CubieA != InvalidIndex
+                && (A.GetCubieHomeSlot(CubieA) != B.GetCubieHomeSlot(CubieB) || A.GetCubieOrientation(CubieA) != B.GetCubieOrientation(CubieB)))
+            {
+                return false;
+            }
+        }
+        return A.GetStateHash() == B.GetStateHash() && A.IsSolved() == B.IsSolved();
+    }
+
+    void TestCubeStateAddRemoveCubie()
+    {
+        // 随机增删方块后，和用同一个掩码重新 Initialize 的状态逐槽位一致，层表、哈希和之后的转动也一致
+        std::mt19937 Random(7);
+        const FCoords AllDimensions[] = { { 2, 2, 2 }, { 3, 3, 3 }, { 4, 4, 4 }, { 3, 4, 5 } };
+        for (const FCoords& Dimensions : AllDimensions)
+        {
+            const int32_t NumSlots = Dimensions.X * Dimensions.Y * Dimensions.Z;
+            std::unique_ptr<bool[]> Mask(new bool[NumSlots]);
+            std::fill(Mask.get(), Mask.get() + NumSlots, true);
+
+            FCubeState State;
+            State.Initialize(Dimensions, nullptr, 0);
+            for (int32_t Edit = 0; Edit < 3 * NumSlots; Edit++)
+            {
+                const int32_t Slot = static_cast<int32_t>(Random() % static_cast<uint32_t>(NumSlots));
+                if (Mask[Slot])
+                {
+                    int32_t MovedCubie = InvalidIndex;
+                    const int32_t LastCubie = State.GetNumCubies() - 1;
+                    const int32_t LastHomeSlot = State.GetCubieHomeSlot(LastCubie);
+                    const int32_t Cubie = State.GetCubieAtSlot(Slot);
+                    CHECK(State.RemoveCubie(Slot, MovedCubie));
+                    CHECK(MovedCubie == (Cubie == LastCubie ? InvalidIndex : LastCubie));
+                    CHECK(MovedCubie == InvalidIndex || State.GetCubieHomeSlot(Cubie) == LastHomeSlot);
+                    CHECK(State.GetFixedOrder() == 0);
+                    Mask[Slot] = false;
+                }
+                else if (State.AddCubie(Slot))
+                {
+                    Mask[Slot] = true;
+                }
+                else
+                {
+                    // 只有补满 2 阶、3 阶时才拒绝
+                    CHECK(State.GetNumCubies() == NumSlots - 1 && Dimensions.X == Dimensions.Y && Dimensions.Y == Dimensions.Z && Dimensions.X <= 3);
+                }
+            }
+
+            FCubeState Reference;
+            Reference.Initialize(Dimensions, Mask.get(), NumSlots);
+            CHECK(State.IsAtHome());
+            CHECK(State.IsSolved());
+            CHECK(SameSlots(State, Reference));
+            for (int32_t AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+            {
+                for (int32_t Layer = 0; Layer < Dimensions[AxisIndex]; Layer++)
+                {
+                    const FIndexSpan Cubies = State.GetLayerCubies(AxisIndex, Layer);
+                    CHECK(Cubies.Num() == Reference.GetLayerCubies(AxisIndex, Layer).Num());
+                    for (int32_t Cubie : Cubies)
+                    {
+                        CHECK(State.GetSlotCoords(State.GetCubieSlot(Cubie))[AxisIndex] == Layer);
+                    }
+                }
+            }
+
+            // 整体转一圈正方形截面的轴仍算还原；再打乱、逐步和批量各走一遍
+            if (Dimensions.X == Dimensions.Y)
+            {
+                for (int32_t Layer = 0; Layer < Dimensions.Z; Layer++)
+                {
+                    State.ApplyMove(2, Layer, 1);
+                    Reference.ApplyMove(2, Layer, 1);
+                }
+                CHECK(SameSlots(State, Reference));
+            }
+            const std::vector<FLayerTurn> Moves = RandomScramble(Random, Dimensions, 100);
+            FCubeState Bulk = State;
+            for (const FLayerTurn& Move : Moves)
+            {
+                State.ApplyMove(Move.AxisIndex, Move.Layer, Move.QuarterTurns);
+                Reference.ApplyMove(Move.AxisIndex, Move.Layer, Move.QuarterTurns);
+            }
+            Bulk.ApplyMoves(Moves.data(), static_cast<int32_t>(Moves.size()));
+            CHECK(SameSlots(State, Reference));
+            CHECK(SameSlots(Bulk, Reference));
+        }
+    }
+
+    void TestFaceletsMoveThenInverse()
+    {
+        std::mt19937 Random(4);
+        for (int32_t Order : { 2, 3, 4, 5, 7, 16, 33 })
+        {
+            FFaceletCube Cube;
+            Cube.Initialize(Order);
+            const std::vector<FLayerTurn> Moves = RandomScramble(Random, FCoords{ Order, Order, Order }, 200);
+            CHECK(Cube.ApplyMoves(Moves.data(), static_cast<int32_t>(Moves.size())) == static_cast<int32_t>(Moves.size()));
+            CHECK(!AreFacesUniform(Cube));
+            for (auto It = Moves.rbegin(); It != Moves.rend(); ++It)
+            {
+                Cube.ApplyMove(It->AxisIndex, It->Layer, -It->QuarterTurns);
+            }
+            for (int32_t Face = 0; Face < FFaceletCube::NumFaces; Face++)
+            {
+                for (int32_t i = 0; i < Order * Order; i++)
+                {
+                    CHECK(Cube.GetFaceData(Face)[i] == Face);
+                }
+            }
+        }
+    }
+
+    void TestFaceletsMatchCubeState()
+    {
+        // 贴纸颜色 = 方块当前朝向下，朝外那一面在初始状态下的方向
+        std::mt19937 Random(5);
+        for (int32_t Order : { 2, 3, 4, 5 })
+        {
+            FCubeState State;
+            State.Initialize(FCoords{ Order, Order, Order }, nullptr, 0);
+            FFaceletCube Cube;
+            Cube.Initialize(Order);
+            const std::vector<FLayerTurn> Moves = RandomScramble(Random, FCoords{ Order, Order, Order }, 100);
+            for (const FLayerTurn& Move : Moves)
+            {
+                State.ApplyMove(Move.AxisIndex, Move.Layer, Move.QuarterTurns);
+                Cube.ApplyMove(Move.AxisIndex, Move.Layer, Move.QuarterTurns);
+            }
+
+            for (int32_t Face = 0; Face < FFaceletCube::NumFaces; Face++)
+            {
+                const int32_t AxisIndex = Face / 2;
+                const int32_t U = (AxisIndex + 1) % 3;
+                const int32_t V = (AxisIndex + 2) % 3;
+                for (int32_t SV = 0; SV < Order; SV++)
+                {
+                    for (int32_t SU = 0; SU < Order; SU++)
+                    {
+                        FCoords Coords;
+                        Coords[AxisIndex] = (Face % 2 == 0) ? Order - 1 : 0;
+                        Coords[U] = SU;
+                        Coords[V] = SV;
+                        const int32_t Cubie = State.GetCubieAtSlot(State.GetSlotIndex(Coords));
+                        const uint8_t Expected = GetOrientationTable().HomeFaces[State.GetCubieOrientation(Cubie)][Face];
+                        CHECK(Cube.GetSticker(Face, SU, SV) == Expected);
+                    }
+                }
+            }
+        }
+    }
+
+    void TestPocketSolver()
+    {
+        std::vector<uint8_t> Table(FPocketCubeSolver::DistanceTableBytes);
+        FPocketCubeSolver Solver;
+        Solver.BuildDistanceTable(Table.data());
+        Solver.SetDistanceTable(Table.data());
+
+        std::mt19937 Random(6);
+        std::vector<FLayerTurn> Solution;
+        for (int32_t i = 0; i < 50; i++)
+        {
+            FCubeState State;
+            State.Initialize(FCoords{ 2, 2, 2 }, nullptr, 0);
+            for (const FLayerTurn& Move : RandomScramble(Random, FCoords{ 2, 2, 2 }, 30))
+            {
+                State.ApplyMove(Move.AxisIndex, Move.Layer, Move.QuarterTurns);
+            }
+
+            CHECK(Solver.Solve(State, Solution));
+            // 2 阶魔方任意状态的最优解不超过 11 步（半圈算一步）
+            CHECK(Solution.size() <= 11);
+            State.ApplyMoves(Solution.data(), static_cast<int32_t>(Solution.size()));
+            CHECK(State.IsSolved());
+        }
+    }
+
+    void TestTwoPhaseSolver()
+    {
+        const FTwoPhaseSolver& Solver = GetTwoPhaseSolver();
+        std::mt19937 Random(7);
+        std::vector<FLayerTurn> Solution;
+        for (int32_t i = 0; i < 20; i++)
+        {
+            // 打乱里带中层转动，中心块也会离开原位
+            FCubeState State;
+            State.Initialize(FCoords{ 3, 3, 3 }, nullptr, 0);
+            for (const FLayerTurn& Move : RandomScramble(Random, FCoords{ 3, 3, 3 }, 40))
+            {
+                State.ApplyMove(Move.AxisIndex, Move.Layer, Move.QuarterTurns);
+            }
+
+            CHECK(Solver.Solve(State, 23, Solution));
+            CHECK(static_cast<int32_t>(Solution.size()) <= FTwoPhaseSolver::MaxSolutionLength);
+            State.ApplyMoves(Solution.data(), static_cast<int32_t>(Solution.size()));
+            CHECK(State.IsSolved());
+        }
+    }
+
+    void TestTwoPhaseSolverCancel()
+    {
+        const FTwoPhaseSolver& Solver = GetTwoPhaseSolver();
+        std::mt19937 Random(8);
+        FCubeState State;
+        State.Initialize(FCoords{ 3, 3, 3 }, nullptr, 0);
+        for (const FLayerTurn& Move : RandomScramble(Random, FCoords{ 3, 3, 3 }, 40))
+        {
+            State.ApplyMove(Move.AxisIndex, Move.Layer, Move.QuarterTurns);
+        }
+
+        FSearchControl Control;
+        Control.bCancel = true;
+        std::vector<FLayerTurn> Solution;
+        CHECK(!Solver.Solve(State, 0, Solution, &Control));
+    }
+
+    void TestReductionSolver()
+    {
+        std::mt19937 Random(9);
+        for (int32_t Order : { 4, 5, 6, 7, 10 })
+        {
+            FFaceletCube Cube;
+            Cube.Initialize(Order);
+            const std::vector<FLayerTurn> Moves = RandomScramble(Random, FCoords{ Order, Order, Order }, 100);
+            Cube.ApplyMoves(Moves.data(), static_cast<int32_t>(Moves.size()));
+
+            // 输出的每一步直接转到另一份副本上，结束时副本应当还原
+            FFaceletCube Replay = Cube;
+            int32_t NumEmitted = 0;
+            FReductionSolver Solver(GetTwoPhaseSolver());
+            const bool bSolved = Solver.Solve(Cube, [&Replay, &NumEmitted](const FLayerTurn& Turn)
+            {
+                Replay.ApplyMove(Turn.AxisIndex, Turn.Layer, Turn.QuarterTurns);
+                NumEmitted++;
+            });
+            CHECK(bSolved);
+            CHECK(NumEmitted > 0);
+            CHECK(AreFacesUniform(Replay));
+        }
+    }
+
+    void TestReductionSolverCancel()
+    {
+        FFaceletCube Cube;
+        Cube.Initialize(6);
+        std::mt19937 Random(10);
+        const std::vector<FLayerTurn> Moves = RandomScramble(Random, FCoords{ 6, 6, 6 }, 100);
+        Cube.ApplyMoves(Moves.data(), static_cast<int32_t>(Moves.size()));
+
+        FSearchControl Control;
+        Control.bCancel = true;
+        FReductionSolver Solver(GetTwoPhaseSolver());
+        CHECK(!Solver.Solve(Cube, [](const FLayerTurn&) {}, &Control));
+    }
+
+    struct FTestCase
+    {
+        const char* Name;
+        void (*Run)();
+    };
+
+    const FTestCase TestCases[] =
+    {
+        { "QuarterTurns", &TestQuarterTurns },
+        { "CubeStateMoveThenInverse", &TestCubeStateMoveThenInverse },
+        { "CubeStateFourQuarterTurns", &TestCubeStateFourQuarterTurns },
+        { "CubeStateRejectsIllegalTurn", &TestCubeStateRejectsIllegalTurn },
+        { "CubeStateLayerTables", &TestCubeStateLayerTables },
+        { "CubeStateApplyMovesMatchesApplyMove", &TestCubeStateApplyMovesMatchesApplyMove },
+        { "CubeStateWholeCubeTurnIsSolved", &TestCubeStateWholeCubeTurnIsSolved },
+        { "CubeStateLayoutMask", &TestCubeStateLayoutMask },
+        { "CubeStateAddRemoveCubie", &TestCubeStateAddRemoveCubie },
+        { "FaceletsMoveThenInverse", &TestFaceletsMoveThenInverse },
+        { "FaceletsMatchCubeState", &TestFaceletsMatchCubeState },
+        { "PocketSolver", &TestPocketSolver },
+        { "TwoPhaseSolver", &TestTwoPhaseSolver },
+        { "TwoPhaseSolverCancel", &TestTwoPhaseSolverCancel },
+        { "ReductionSolver", &TestReductionSolver },
+        { "ReductionSolverCancel", &TestReductionSolverCancel },
+    };
+}
+
+int main(int Argc, char** Argv)
+{
+    const char* Filter = Argc > 1 ? Argv[1] : nullptr;
+    int32_t NumRun = 0;
+    for (const FTestCase& Test : TestCases)
+    {
+        if (Filter && std::strcmp(Filter, Test.Name) != 0)
+        {
+            continue;
+        }
+        const int32_t FailuresBefore = NumFailures;
+        Test.Run();
+        std::printf("%s %s\n", NumFailures == FailuresBefore ? "[  OK  ]" : "[ FAIL ]", Test.Name);
+        NumRun++;
+    }
+
+    if (NumRun == 0)
+    {
+        std::fprintf(stderr, "unknown test: %s\n", Filter);
+        return 1;
+    }
+    return NumFailures == 0 ? 0 : 1;
+}